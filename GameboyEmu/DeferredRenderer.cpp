@@ -0,0 +1,203 @@
+//
+//  DeferredRenderer.cpp
+//  GameboyEmu
+//
+//  Created by David Spickett on 18/10/2026.
+//  Copyright © 2026 David Spickett. All rights reserved.
+//
+
+#include "DeferredRenderer.hpp"
+
+namespace
+{
+    //Lines are handed to the worker in groups to keep locking down
+    const size_t LINES_PER_BATCH = 16;
+    //About 2 frames, after that the emulator waits for the worker
+    const size_t MAX_PENDING_BATCHES = 20;
+}
+
+DeferredRenderer::DeferredRenderer(const LCDRenderer& renderer, TripleBuffer<PublishedFrame>& frames):
+    m_renderer(renderer),
+    m_frames(frames),
+    m_batch(new RenderBatch()),
+    m_busy(false),
+    m_quit(false)
+{
+    m_thread = std::thread(&DeferredRenderer::run, this);
+}
+
+DeferredRenderer::~DeferredRenderer()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_quit = true;
+    }
+    m_work_ready.notify_one();
+    m_thread.join();
+}
+
+void DeferredRenderer::add_event(RenderEvent::Type type, uint8_t line, bool publish, size_t frame_number, const LCDRegisters& regs)
+{
+    RenderEvent event;
+    event.type = type;
+    event.writes_before = m_batch->writes.size();
+    event.line = line;
+    event.publish = publish;
+    event.frame_number = frame_number;
+    event.regs = regs;
+    m_batch->events.push_back(event);
+}
+
+void DeferredRenderer::write_oam(const uint8_t* data)
+{
+    OAMData copy;
+    std::copy(data, data+copy.size(), copy.begin());
+    m_batch->writes.push_back(VRAMWrite(LCD_OAM_START, uint16_t(m_batch->oam_copies.size()), VRAMWrite::OAM_COPY));
+    m_batch->oam_copies.push_back(copy);
+}
+
+void DeferredRenderer::draw_line(uint8_t line, const LCDRegisters& regs)
+{
+    add_event(RenderEvent::DRAW_LINE, line, false, 0, regs);
+    if (m_batch->events.size() >= LINES_PER_BATCH)
+    {
+        submit();
+    }
+}
+
+void DeferredRenderer::end_frame(bool publish, size_t frame_number)
+{
+    add_event(RenderEvent::END_FRAME, 0, publish, frame_number, LCDRegisters());
+    submit();
+}
+
+void DeferredRenderer::blank(size_t frame_number)
+{
+    add_event(RenderEvent::BLANK, 0, true, frame_number, LCDRegisters());
+    submit();
+}
+
+void DeferredRenderer::submit()
+{
+    std::unique_ptr<RenderBatch> next;
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_work_done.wait(lock, [this]() { return m_pending.size() < MAX_PENDING_BATCHES; });
+        m_pending.push_back(std::move(m_batch));
+        if (!m_free.empty())
+        {
+            next = std::move(m_free.back());
+            m_free.pop_back();
+        }
+    }
+    m_work_ready.notify_one();
+    
+    m_batch = next ? std::move(next) : std::unique_ptr<RenderBatch>(new RenderBatch());
+}
+
+void DeferredRenderer::finish()
+{
+    if (!m_batch->writes.empty() || !m_batch->events.empty())
+    {
+        submit();
+    }
+    
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_work_done.wait(lock, [this]() { return m_pending.empty() && !m_busy; });
+}
+
+uint64_t DeferredRenderer::frame_hash()
+{
+    //The worker is idle after this, so its frame is safe to read
+    finish();
+    return ::frame_hash(m_renderer.frame());
+}
+
+RenderStats DeferredRenderer::render_stats()
+{
+    finish();
+    return m_renderer.stats();
+}
+
+void DeferredRenderer::run()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true)
+    {
+        m_work_ready.wait(lock, [this]() { return m_quit || !m_pending.empty(); });
+        if (m_pending.empty())
+        {
+            //Quitting and everything submitted has been drawn
+            break;
+        }
+        
+        std::unique_ptr<RenderBatch> batch = std::move(m_pending.front());
+        m_pending.pop_front();
+        m_busy = true;
+        lock.unlock();
+        
+        render(*batch);
+        batch->writes.clear();
+        batch->oam_copies.clear();
+        batch->events.clear();
+        
+        lock.lock();
+        m_free.push_back(std::move(batch));
+        m_busy = false;
+        m_work_done.notify_all();
+    }
+}
+
+void DeferredRenderer::render(const RenderBatch& batch)
+{
+    size_t applied = 0;
+    auto apply_writes = [&](size_t end)
+    {
+        for ( ; applied < end; ++applied)
+        {
+            const VRAMWrite& write = batch.writes[applied];
+            switch (write.size)
+            {
+                case VRAMWrite::BYTE:
+                    m_renderer.write8(write.addr, uint8_t(write.value));
+                    break;
+                case VRAMWrite::WORD:
+                    m_renderer.write16(write.addr, write.value);
+                    break;
+                case VRAMWrite::OAM_COPY:
+                    m_renderer.write_oam(batch.oam_copies[write.value].data());
+                    break;
+            }
+        }
+    };
+    
+    for (auto& event : batch.events)
+    {
+        apply_writes(event.writes_before);
+        
+        switch (event.type)
+        {
+            case RenderEvent::DRAW_LINE:
+                m_renderer.draw_line(event.line, event.regs);
+                break;
+            case RenderEvent::END_FRAME:
+                if (event.publish)
+                {
+                    publish_frame(event.frame_number);
+                }
+                break;
+            case RenderEvent::BLANK:
+                m_renderer.blank();
+                publish_frame(event.frame_number);
+                break;
+        }
+    }
+    apply_writes(batch.writes.size());
+}
+
+void DeferredRenderer::publish_frame(size_t number)
+{
+    m_frames.back().frame = m_renderer.frame();
+    m_frames.back().number = number;
+    m_frames.publish();
+}
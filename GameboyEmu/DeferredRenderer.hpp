@@ -0,0 +1,114 @@
+//
+//  DeferredRenderer.hpp
+//  GameboyEmu
+//
+//  Created by David Spickett on 18/10/2026.
+//  Copyright © 2026 David Spickett. All rights reserved.
+//
+
+#ifndef DeferredRenderer_hpp
+#define DeferredRenderer_hpp
+
+#include "LCDRenderer.hpp"
+#include "TripleBuffer.hpp"
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+/*Draws scanlines on a worker thread while the emulator carries on. The
+ LCD logs VRAM/OAM writes and a copy of the registers for each scanline,
+ the worker replays them in order into its own copy of VRAM so the frames
+ are the same as drawing them straight away.*/
+class DeferredRenderer
+{
+    public:
+        //Starts from a copy of the current VRAM and OAM
+        DeferredRenderer(const LCDRenderer& renderer, TripleBuffer<PublishedFrame>& frames);
+        ~DeferredRenderer();
+    
+        //The rest are called by the emulator thread
+        void write8(uint16_t addr, uint8_t value)
+        {
+            m_batch->writes.push_back(VRAMWrite(addr, value, VRAMWrite::BYTE));
+        }
+        void write16(uint16_t addr, uint16_t value)
+        {
+            m_batch->writes.push_back(VRAMWrite(addr, value, VRAMWrite::WORD));
+        }
+        void write_oam(const uint8_t* data);
+    
+        void draw_line(uint8_t line, const LCDRegisters& regs);
+        //Publish is set if the frame should go to m_frames, numbered frame_number
+        void end_frame(bool publish, size_t frame_number);
+        //Fill with white and publish
+        void blank(size_t frame_number);
+    
+        //Waits until everything logged so far has been drawn
+        void finish();
+        uint64_t frame_hash();
+        RenderStats render_stats();
+    
+    private:
+        struct VRAMWrite
+        {
+            //For OAM_COPY, value is an index into the batch's oam_copies
+            enum Size { BYTE, WORD, OAM_COPY };
+            
+            VRAMWrite(uint16_t addr, uint16_t value, Size size):
+                addr(addr), value(value), size(size)
+            {}
+            
+            uint16_t addr;
+            uint16_t value;
+            Size size;
+        };
+    
+        struct RenderEvent
+        {
+            enum Type { DRAW_LINE, END_FRAME, BLANK };
+            
+            Type type;
+            //Number of writes in the batch to apply before this
+            size_t writes_before;
+            uint8_t line;
+            bool publish;
+            size_t frame_number;
+            LCDRegisters regs;
+        };
+    
+        struct RenderBatch
+        {
+            std::vector<VRAMWrite> writes;
+            std::vector<OAMData> oam_copies;
+            std::vector<RenderEvent> events;
+        };
+    
+        void add_event(RenderEvent::Type type, uint8_t line, bool publish, size_t frame_number, const LCDRegisters& regs);
+        void submit();
+        void run();
+        void render(const RenderBatch& batch);
+        void publish_frame(size_t number);
+    
+        //Only touched by the worker once it has started
+        LCDRenderer m_renderer;
+        TripleBuffer<PublishedFrame>& m_frames;
+    
+        //The batch being logged into by the emulator thread
+        std::unique_ptr<RenderBatch> m_batch;
+    
+        std::mutex m_mutex;
+        std::condition_variable m_work_ready;
+        std::condition_variable m_work_done;
+        std::deque<std::unique_ptr<RenderBatch>> m_pending;
+        //Drawn batches, reused to save allocating
+        std::vector<std::unique_ptr<RenderBatch>> m_free;
+        bool m_busy;
+        bool m_quit;
+    
+        std::thread m_thread;
+};
+
+#endif /* DeferredRenderer_hpp */
@@ -0,0 +1,155 @@
+//
+//  Disassembler.cpp
+//  GameboyEmu
+//
+//  Created by David Spickett on 18/10/2026.
+//  Copyright © 2026 David Spickett. All rights reserved.
+//
+
+#include "Disassembler.hpp"
+#include "utils.hpp"
+
+namespace
+{
+    /*Operand tokens are replaced with the bytes that follow the opcode.
+     d8/a8/r8 take one byte, d16/a16 take two.*/
+    const char* BASE_OPS[256] = {
+        "nop", "ld bc, d16", "ld (bc), a", "inc bc", "inc b", "dec b", "ld b, d8", "rlca",
+        "ld (a16), sp", "add hl, bc", "ld a, (bc)", "dec bc", "inc c", "dec c", "ld c, d8", "rrca",
+        //The emulator always fetches a second byte for stop
+        "stop d8", "ld de, d16", "ld (de), a", "inc de", "inc d", "dec d", "ld d, d8", "rla",
+        "jr r8", "add hl, de", "ld a, (de)", "dec de", "inc e", "dec e", "ld e, d8", "rra",
+        "jr nz, r8", "ld hl, d16", "ld (hl+), a", "inc hl", "inc h", "dec h", "ld h, d8", "daa",
+        "jr z, r8", "add hl, hl", "ld a, (hl+)", "dec hl", "inc l", "dec l", "ld l, d8", "cpl",
+        "jr nc, r8", "ld sp, d16", "ld (hl-), a", "inc sp", "inc (hl)", "dec (hl)", "ld (hl), d8", "scf",
+        "jr c, r8", "add hl, sp", "ld a, (hl-)", "dec sp", "inc a", "dec a", "ld a, d8", "ccf",
+        
+        "ld b, b", "ld b, c", "ld b, d", "ld b, e", "ld b, h", "ld b, l", "ld b, (hl)", "ld b, a",
+        "ld c, b", "ld c, c", "ld c, d", "ld c, e", "ld c, h", "ld c, l", "ld c, (hl)", "ld c, a",
+        "ld d, b", "ld d, c", "ld d, d", "ld d, e", "ld d, h", "ld d, l", "ld d, (hl)", "ld d, a",
+        "ld e, b", "ld e, c", "ld e, d", "ld e, e", "ld e, h", "ld e, l", "ld e, (hl)", "ld e, a",
+        "ld h, b", "ld h, c", "ld h, d", "ld h, e", "ld h, h", "ld h, l", "ld h, (hl)", "ld h, a",
+        "ld l, b", "ld l, c", "ld l, d", "ld l, e", "ld l, h", "ld l, l", "ld l, (hl)", "ld l, a",
+        "ld (hl), b", "ld (hl), c", "ld (hl), d", "ld (hl), e", "ld (hl), h", "ld (hl), l", "halt", "ld (hl), a",
+        "ld a, b", "ld a, c", "ld a, d", "ld a, e", "ld a, h", "ld a, l", "ld a, (hl)", "ld a, a",
+        
+        "add a, b", "add a, c", "add a, d", "add a, e", "add a, h", "add a, l", "add a, (hl)", "add a, a",
+        "adc a, b", "adc a, c", "adc a, d", "adc a, e", "adc a, h", "adc a, l", "adc a, (hl)", "adc a, a",
+        "sub b", "sub c", "sub d", "sub e", "sub h", "sub l", "sub (hl)", "sub a",
+        "sbc a, b", "sbc a, c", "sbc a, d", "sbc a, e", "sbc a, h", "sbc a, l", "sbc a, (hl)", "sbc a, a",
+        "and b", "and c", "and d", "and e", "and h", "and l", "and (hl)", "and a",
+        "xor b", "xor c", "xor d", "xor e", "xor h", "xor l", "xor (hl)", "xor a",
+        "or b", "or c", "or d", "or e", "or h", "or l", "or (hl)", "or a",
+        "cp b", "cp c", "cp d", "cp e", "cp h", "cp l", "cp (hl)", "cp a",
+        
+        "ret nz", "pop bc", "jp nz, a16", "jp a16", "call nz, a16", "push bc", "add a, d8", "rst 00h",
+        "ret z", "ret", "jp z, a16", "prefix cb", "call z, a16", "call a16", "adc a, d8", "rst 08h",
+        "ret nc", "pop de", "jp nc, a16", NULL, "call nc, a16", "push de", "sub d8", "rst 10h",
+        "ret c", "reti", "jp c, a16", NULL, "call c, a16", NULL, "sbc a, d8", "rst 18h",
+        "ldh (a8), a", "pop hl", "ld (c), a", NULL, NULL, "push hl", "and d8", "rst 20h",
+        "add sp, r8", "jp (hl)", "ld (a16), a", NULL, NULL, NULL, "xor d8", "rst 28h",
+        "ldh a, (a8)", "pop af", "ld a, (c)", "di", NULL, "push af", "or d8", "rst 30h",
+        "ld hl, spr8", "ld sp, hl", "ld a, (a16)", "ei", NULL, NULL, "cp d8", "rst 38h",
+    };
+    
+    const char* CB_OPS[] = {"rlc", "rrc", "rl", "rr", "sla", "sra", "swap", "srl"};
+    const char* CB_BIT_OPS[] = {NULL, "bit", "res", "set"};
+    const char* REG_NAMES[] = {"b", "c", "d", "e", "h", "l", "(hl)", "a"};
+    
+    uint8_t operand_size(const std::string& op)
+    {
+        if ((op.find("d16") != std::string::npos) || (op.find("a16") != std::string::npos))
+        {
+            return 2;
+        }
+        if ((op.find("d8") != std::string::npos) || (op.find("a8") != std::string::npos) ||
+            (op.find("r8") != std::string::npos))
+        {
+            return 1;
+        }
+        return 0;
+    }
+    
+    void replace_token(std::string& op, const std::string& token, const std::string& value)
+    {
+        size_t pos = op.find(token);
+        if (pos != std::string::npos)
+        {
+            op.replace(pos, token.size(), value);
+        }
+    }
+}
+
+uint8_t instruction_length(uint8_t opcode)
+{
+    if (opcode == 0xcb)
+    {
+        return 2;
+    }
+    
+    const char* op = BASE_OPS[opcode];
+    return op ? 1 + operand_size(op) : 1;
+}
+
+std::string disassemble(uint16_t pc, const uint8_t* bytes, uint8_t length)
+{
+    if (length == 0)
+    {
+        return "??";
+    }
+    
+    uint8_t opcode = bytes[0];
+    if (opcode == 0xcb)
+    {
+        if (length < 2)
+        {
+            return "prefix cb ??";
+        }
+        
+        uint8_t cb = bytes[1];
+        const char* reg = REG_NAMES[cb & 7];
+        if (cb < 0x40)
+        {
+            return formatted_string("%s %s", CB_OPS[cb >> 3], reg);
+        }
+        return formatted_string("%s %d, %s", CB_BIT_OPS[cb >> 6], (cb >> 3) & 7, reg);
+    }
+    
+    const char* base = BASE_OPS[opcode];
+    if (!base)
+    {
+        return formatted_string("db 0x%02x", opcode);
+    }
+    
+    std::string op(base);
+    uint8_t operands = operand_size(op);
+    if (length < 1+operands)
+    {
+        return op;
+    }
+    
+    if (operands == 2)
+    {
+        std::string value = formatted_string("0x%04x", bytes[1] | (bytes[2] << 8));
+        replace_token(op, "d16", value);
+        replace_token(op, "a16", value);
+    }
+    else if (operands == 1)
+    {
+        replace_token(op, "d8", formatted_string("0x%02x", bytes[1]));
+        replace_token(op, "a8", formatted_string("0x%02x", bytes[1]));
+        
+        int8_t offset = int8_t(bytes[1]);
+        if (op.compare(0, 2, "jr") == 0)
+        {
+            //Show the target rather than the offset
+            replace_token(op, "r8", formatted_string("0x%04x", uint16_t(pc+2+offset)));
+        }
+        else
+        {
+            replace_token(op, "r8", formatted_string("%+d", offset));
+        }
+    }
+    
+    return op;
+}
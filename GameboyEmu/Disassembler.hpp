@@ -0,0 +1,22 @@
+//
+//  Disassembler.hpp
+//  GameboyEmu
+//
+//  Created by David Spickett on 18/10/2026.
+//  Copyright © 2026 David Spickett. All rights reserved.
+//
+
+#ifndef Disassembler_hpp
+#define Disassembler_hpp
+
+#include <stdint.h>
+#include <string>
+
+//Total length of the instruction starting with this opcode, including the opcode
+uint8_t instruction_length(uint8_t opcode);
+
+/*Disassemble the instruction at pc. bytes must hold at least
+ instruction_length(bytes[0]) bytes, fewer results in "??" operands.*/
+std::string disassemble(uint16_t pc, const uint8_t* bytes, uint8_t length);
+
+#endif /* Disassembler_hpp */
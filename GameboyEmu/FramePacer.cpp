@@ -0,0 +1,145 @@
+//
+//  FramePacer.cpp
+//  GameboyEmu
+//
+//  Created by David Spickett on 18/10/2026.
+//  Copyright © 2026 David Spickett. All rights reserved.
+//
+
+#include "FramePacer.hpp"
+#include <algorithm>
+#include <thread>
+#include <stdexcept>
+#include "utils.hpp"
+
+namespace
+{
+    //70224 clocks per frame at 4194304Hz, ~59.7 frames per second
+    const std::chrono::nanoseconds FRAME_DURATION(16742706);
+    
+    //If we fall further behind than this, start again from now instead of rushing to catch up
+    const std::chrono::milliseconds MAX_LAG(100);
+    
+    /*Aim to keep this many samples queued, 2 of the audio callback's
+     requests. More adds latency, less risks running dry.*/
+    const size_t TARGET_QUEUED_SAMPLES = 2048;
+    
+    //Largest change to the sample rate, small enough not to be heard as a change in pitch
+    const double MAX_RATE_DELTA = 0.005;
+    
+    //Don't hang if the audio device stops taking samples
+    const std::chrono::milliseconds MAX_AUDIO_WAIT(50);
+    
+    //Turbo mode draws at most 60 frames per second
+    const std::chrono::microseconds DISPLAY_INTERVAL(16667);
+}
+
+SyncMode parse_sync_mode(const std::string& name)
+{
+    if (name == "none")
+    {
+        return SYNC_NONE;
+    }
+    else if (name == "clock")
+    {
+        return SYNC_CLOCK;
+    }
+    else if (name == "audio")
+    {
+        return SYNC_AUDIO;
+    }
+    throw std::runtime_error(formatted_string("Unknown sync mode \"%s\". (expected audio, clock or none)", name.c_str()));
+}
+
+FramePacer::FramePacer(SyncMode mode, SoundHandler& sound):
+    m_mode(mode),
+    m_sound(sound),
+    m_next_frame(std::chrono::steady_clock::now()),
+    m_turbo(false),
+    m_next_display(m_next_frame)
+{}
+
+void FramePacer::set_mode(SyncMode mode)
+{
+    m_mode = mode;
+    m_next_frame = std::chrono::steady_clock::now();
+    m_sound.set_rate_ratio(1.0);
+}
+
+void FramePacer::set_turbo(bool turbo)
+{
+    m_turbo = turbo;
+    //Resume pacing from now, not from when turbo started
+    set_mode(m_mode);
+}
+
+bool FramePacer::FrameDone()
+{
+    if (m_turbo)
+    {
+        auto now = std::chrono::steady_clock::now();
+        if (now < m_next_display)
+        {
+            return false;
+        }
+        m_next_display = now + DISPLAY_INTERVAL;
+        return true;
+    }
+    
+    switch (m_mode)
+    {
+        case SYNC_NONE:
+            break;
+        case SYNC_CLOCK:
+            wait_for_clock();
+            break;
+        case SYNC_AUDIO:
+            if (m_sound.audio_running())
+            {
+                wait_for_audio();
+            }
+            else
+            {
+                wait_for_clock();
+            }
+            break;
+    }
+    return true;
+}
+
+void FramePacer::wait_for_clock()
+{
+    m_next_frame += FRAME_DURATION;
+    
+    auto now = std::chrono::steady_clock::now();
+    if (now < m_next_frame)
+    {
+        std::this_thread::sleep_until(m_next_frame);
+    }
+    else if ((now - m_next_frame) > MAX_LAG)
+    {
+        m_next_frame = now;
+    }
+}
+
+void FramePacer::wait_for_audio()
+{
+    /*The audio device plays at its own rate, so when it has enough queued
+     up we wait for it to catch up.*/
+    auto give_up = std::chrono::steady_clock::now() + MAX_AUDIO_WAIT;
+    while ((m_sound.m_samples.size() > TARGET_QUEUED_SAMPLES) &&
+           (std::chrono::steady_clock::now() < give_up))
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    
+    /*Then nudge the sample rate towards the target level. Making more samples
+     when the queue is low avoids underruns (clicks) without a big jump in pitch.*/
+    double queued = double(m_sound.m_samples.size());
+    double error = (TARGET_QUEUED_SAMPLES - queued) / TARGET_QUEUED_SAMPLES;
+    double delta = std::max(-MAX_RATE_DELTA, std::min(MAX_RATE_DELTA, error * MAX_RATE_DELTA));
+    m_sound.set_rate_ratio(1.0 + delta);
+    
+    //Keep the clock in step in case sound is turned off
+    m_next_frame = std::chrono::steady_clock::now();
+}
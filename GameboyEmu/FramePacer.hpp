@@ -0,0 +1,59 @@
+//
+//  FramePacer.hpp
+//  GameboyEmu
+//
+//  Created by David Spickett on 18/10/2026.
+//  Copyright © 2026 David Spickett. All rights reserved.
+//
+
+#ifndef FramePacer_hpp
+#define FramePacer_hpp
+
+#include <chrono>
+#include <string>
+#include "SoundHandler.hpp"
+
+enum SyncMode {
+    //Run as fast as possible
+    SYNC_NONE,
+    //Sleep until each frame is due, by the host's clock
+    SYNC_CLOCK,
+    //Keep the sound buffer at a steady level, falling back to SYNC_CLOCK without sound
+    SYNC_AUDIO
+};
+
+SyncMode parse_sync_mode(const std::string& name);
+
+/*Holds emulation to real time speed, sleeping instead of spinning so
+ that the emulator only uses the CPU time it needs.*/
+class FramePacer
+{
+public:
+    FramePacer(SyncMode mode, SoundHandler& sound);
+    
+    /*Call at the end of every emulated frame, waits until the next one should start.
+     Returns whether the next frame should be drawn.*/
+    bool FrameDone();
+    
+    SyncMode mode() const { return m_mode; }
+    void set_mode(SyncMode mode);
+    
+    /*Turbo runs as fast as possible, drawing only as many frames as the
+     display can show. That is every Nth frame, where N depends on how far
+     ahead of real time the emulator is running.*/
+    bool turbo() const { return m_turbo; }
+    void set_turbo(bool turbo);
+    
+private:
+    void wait_for_clock();
+    void wait_for_audio();
+    
+    SyncMode m_mode;
+    SoundHandler& m_sound;
+    std::chrono::steady_clock::time_point m_next_frame;
+    
+    bool m_turbo;
+    std::chrono::steady_clock::time_point m_next_display;
+};
+
+#endif /* FramePacer_hpp */
@@ -8,6 +8,7 @@
 
 #include "HardwareIORegs.hpp"
 #include "Z80.hpp"
+#include <algorithm>
 
 namespace
 {
@@ -15,6 +16,8 @@ namespace
     const uint16_t TIMECNT  = 0xff05;
     const uint16_t TIMEMOD  = 0xff06;
     const uint16_t TIMECONT = 0xff07;
+    
+    const size_t DIVIDER_PERIOD = 256;
 }
 
 uint8_t HardwareIORegs::read8(uint16_t addr)
@@ -22,18 +25,20 @@ uint8_t HardwareIORegs::read8(uint16_t addr)
     switch (addr)
     {
         case SERIAL_CONTROL:
-            //Not sure if we need to remove the transfer bit, probably won't get read anyway
+            //The transfer bit is cleared when it finishes
             return m_serial_control;
         case SERIAL_DATA:
-            return m_serial_data_recieved;
+            return m_serial_data;
         case TIMEMOD:
             return m_time_mod;
         case TIMECNT:
+            sync_timer(m_cycles);
             return m_time_cnt;
         case TIMECONT:
             return m_time_cont;
         case DIVCOUNT:
-            return m_divider_cnt;
+            //Note overflow at 255 is done for us
+            return uint8_t((m_cycles / DIVIDER_PERIOD) - m_divider_base);
         case INTERRUPT_FLAGS:
             return m_interrupt_flags;
         case INTERRUPT_SWITCH:
@@ -59,27 +64,34 @@ void HardwareIORegs::write8(uint16_t addr, uint8_t value)
                         throw std::runtime_error("Tried to start a serial transfer with one already in progress!");
                     }
                     
-                    //Nothing connected returns 0xff
-                    m_serial_transfer = SerialTransfer(0xff);
-                }
-                else
-                {
-                    m_serial_data_recieved = 0x0;
+                    m_serial_transfer = SerialTransfer(m_serial_data, m_cycles+SERIAL_TRANSFER_CYCLES);
+                    if (m_link)
+                    {
+                        m_link->send(m_serial_data, m_serial_transfer.done_at);
+                    }
+                    schedule();
                 }
+                //With the external clock we wait for the other end to start one
             }
             m_serial_control = value;
             break;
         case SERIAL_DATA:
-            //Print for instruction tests
-            printf("%c", value);
+            //For test ROMs that print their results
+            m_serial_output.write(value);
+            m_serial_data = value;
             break;
         case TIMEMOD:
             m_time_mod = value;
             break;
         case TIMECNT:
+            //Increments up to now are overwritten, but keep the timer's phase
+            sync_timer(m_cycles);
             m_time_cnt = value;
+            schedule();
             break;
         case TIMECONT:
+            //Finish counting at the old rate, then start a new period from now
+            sync_timer(m_cycles);
             m_time_cont = value;
             
             m_clock_enable = value & (1 << 2);
@@ -89,24 +101,25 @@ void HardwareIORegs::write8(uint16_t addr, uint8_t value)
             switch (m_time_cont & 3)
             {
                 case 0: //4096
-                    m_timer_countdown_start = 1024;
+                    m_timer_period = 1024;
                     break;
                 case 1: //262144
-                    m_timer_countdown_start = 16;
+                    m_timer_period = 16;
                     break;
                 case 2: //65536
-                    m_timer_countdown_start = 64;
+                    m_timer_period = 64;
                     break;
                 case 3: //16384
-                    m_timer_countdown_start = 256;
+                    m_timer_period = 256;
                     break;
                     
             }
-            m_timer_countdown = m_timer_countdown_start;
+            m_timer_base = m_cycles;
+            schedule();
             
             break;
         case DIVCOUNT:
-            m_divider_cnt = 0;
+            m_divider_base = m_cycles / DIVIDER_PERIOD;
             break;
         case INTERRUPT_FLAGS:
             m_interrupt_flags = value;
@@ -119,65 +132,178 @@ void HardwareIORegs::write8(uint16_t addr, uint8_t value)
     }
 }
 
-void HardwareIORegs::tick(size_t curr_cycles)
+void HardwareIORegs::sync_timer(size_t curr_cycles)
 {
-    size_t cycles_passed = curr_cycles - m_cycles;
-    m_cycles = curr_cycles;
-    
-    //Divider register
-    if (m_divider_countdown > cycles_passed)
-    {
-        m_divider_countdown -= cycles_passed;
-    }
-    else
+    if (!m_clock_enable)
     {
-        uint32_t spare_cycles = uint32_t(cycles_passed) - m_divider_countdown;
-        m_divider_cnt += 1; //Note overflow at 255 is done for us
-        m_divider_countdown = 256 - spare_cycles;
+        return;
     }
     
-    //Timer
-    if (m_clock_enable)
+    size_t increments = (curr_cycles - m_timer_base) / m_timer_period;
+    m_timer_base += increments * m_timer_period;
+    
+    while (increments)
     {
-        //Note that we're assuming nothing is going to take more than 16 cycles!
-        if (m_timer_countdown > cycles_passed)
+        size_t to_overflow = 0x100 - m_time_cnt;
+        if (increments < to_overflow)
         {
-            m_timer_countdown -= cycles_passed;
+            m_time_cnt += increments;
+            break;
         }
-        else
+        increments -= to_overflow;
+        
+        //When it overflows at 255 we set it back to the time mod value.
+        //time mod is NOT a limit, it's a starting point.
+        m_time_cnt = m_time_mod;
+        post_int(TIMER_OVERFLOW);
+    }
+}
+
+void HardwareIORegs::schedule()
+{
+    m_next_event = NO_EVENT;
+    if (m_clock_enable)
+    {
+        m_next_event = m_timer_base + ((0x100 - m_time_cnt) * m_timer_period);
+    }
+    if (m_serial_transfer.valid())
+    {
+        m_next_event = std::min(m_next_event, m_serial_transfer.done_at);
+    }
+    //The other end is held up until we answer, so run to its transfer without syncing
+    if (m_peer_transfer.valid())
+    {
+        m_next_event = std::min(m_next_event, m_peer_transfer.done_at);
+    }
+    else if (m_link)
+    {
+        m_next_event = std::min(m_next_event, m_next_sync);
+    }
+}
+
+void HardwareIORegs::connect(SerialLink* link)
+{
+    m_link = link;
+    m_peer_transfer = SerialTransfer();
+    m_last_peer_answer = 0;
+    m_next_sync = m_cycles;
+    schedule();
+}
+
+void HardwareIORegs::sync_link(size_t curr_cycles)
+{
+    while (!m_link->sync(curr_cycles))
+    {
+        check_peer_transfer();
+        if (m_peer_transfer.valid())
         {
-            //We would overflow if we tried to deduct the cycles
-            uint32_t spare_cycles = uint32_t(cycles_passed) - m_timer_countdown;
-            
-            //Inc the actual timer register
-            if (m_time_cnt == 0xff)
-            {
-                //When it overflows at 255 we set it back to the time mod value.
-                //time mod is NOT a limit, it's a starting point.
-                m_time_cnt = m_time_mod;
-                post_int(TIMER_OVERFLOW);
-            }
-            else
-            {
-                m_time_cnt += 1;
-            }
-            
-            //Apply the remainder to the new value, setting it to the start count first
-            m_timer_countdown = m_timer_countdown_start - spare_cycles;
+            return;
         }
     }
+    m_next_sync = curr_cycles + m_link->sync_interval();
+    check_peer_transfer();
+}
+
+void HardwareIORegs::check_peer_transfer()
+{
+    //The other end waits for our reply before it can send another
+    uint8_t value = 0;
+    size_t done_at = 0;
+    if (!m_peer_transfer.valid() && m_link->peer_transfer(value, done_at))
+    {
+        m_peer_transfer = SerialTransfer(value, done_at);
+        m_peer_transfer_late = m_cycles > done_at;
+    }
     
-    //Serial is lowest priority int so it's at the end
-    if (m_serial_transfer.valid())
+    //If we're waiting on the other end it could be waiting for this
+    if (peer_transfer_due())
+    {
+        answer_peer_transfer();
+    }
+}
+
+bool HardwareIORegs::peer_transfer_due() const
+{
+    if (!m_peer_transfer.valid() || (m_cycles < m_peer_transfer.done_at))
+    {
+        return false;
+    }
+    
+    /*If we heard about it late the program may not be ready for it yet.
+     Give it as long as it would have had between transfers on real hardware,
+     unless it's busy with a transfer of its own.*/
+    return !m_peer_transfer_late || serial_waiting() || m_serial_transfer.valid() ||
+        (m_cycles >= (m_last_peer_answer + SERIAL_TRANSFER_CYCLES));
+}
+
+bool HardwareIORegs::serial_waiting() const
+{
+    //Transfer requested with the external clock
+    return (m_serial_control & 0x81) == 0x80;
+}
+
+void HardwareIORegs::answer_peer_transfer()
+{
+    //Only shifted if we're waiting with the external clock, otherwise it's as if nothing is connected
+    if (serial_waiting())
     {
-        m_serial_transfer.cycles -= cycles_passed;
-        if (m_serial_transfer.cycles <= 0)
+        m_link->reply(m_serial_data);
+        m_serial_data = m_peer_transfer.value;
+        m_serial_control &= ~0x80;
+        post_int(END_SERIAL);
+    }
+    else
+    {
+        m_link->reply(0xff);
+    }
+    m_peer_transfer = SerialTransfer();
+    m_last_peer_answer = m_cycles;
+}
+
+void HardwareIORegs::finish_serial_transfer()
+{
+    //Nothing connected returns 0xff
+    uint8_t value = 0xff;
+    if (m_link)
+    {
+        while (!m_link->receive(m_cycles, value))
         {
-            m_serial_transfer.cycles = -1;
-            m_serial_data_recieved = m_serial_transfer.value;
-            post_int(END_SERIAL);
+            check_peer_transfer();
         }
     }
+    m_serial_data = value;
+    m_serial_control &= ~0x80;
+    m_serial_transfer = SerialTransfer();
+    post_int(END_SERIAL);
+}
+
+void HardwareIORegs::tick(size_t curr_cycles)
+{
+    m_cycles = curr_cycles;
+    if (curr_cycles < m_next_event)
+    {
+        return;
+    }
+    
+    sync_timer(curr_cycles);
+    
+    if (m_link && !m_peer_transfer.valid() && (curr_cycles >= m_next_sync))
+    {
+        sync_link(curr_cycles);
+    }
+    
+    //Serial is lowest priority int so it's at the end.
+    //Answer the other end first in case it's waiting on us while we wait on it.
+    if (peer_transfer_due())
+    {
+        answer_peer_transfer();
+    }
+    if (m_serial_transfer.valid() && (curr_cycles >= m_serial_transfer.done_at))
+    {
+        finish_serial_transfer();
+    }
+    
+    schedule();
 }
 
 uint16_t HardwareIORegs::read16(uint16_t addr)
@@ -10,21 +10,27 @@
 #define HardwareIORegs_hpp
 
 #include "MemoryManager.hpp"
+#include "SerialLink.hpp"
+#include "SerialOutput.hpp"
 
 class HardwareIORegs: public MemoryManager
 {
 public:
     HardwareIORegs():
-        m_clock_enable(false),
-        m_timer_countdown_start(1024),
-        m_timer_countdown(1024),
-        m_divider_countdown(256),
+        m_link(nullptr),
+        m_next_sync(0),
+        m_last_peer_answer(0),
+        m_peer_transfer_late(false),
         m_cycles(0),
-        m_divider_cnt(0),
+        m_clock_enable(false),
         m_time_cont(0),
+        m_timer_period(1024),
+        m_timer_base(0),
+        m_divider_base(0),
+        m_next_event(NO_EVENT),
         m_time_mod(0),
         m_time_cnt(0),
-        m_serial_data_recieved(0),
+        m_serial_data(0),
         m_serial_control(0),
         m_interrupt_flags(0),
         m_interrupt_switch(0)
@@ -38,6 +44,14 @@ public:
     void write16(uint16_t addr, uint16_t value);
     
     void tick(size_t curr_cycles);
+    //Cycle count at which the timer or serial will next raise an interrupt, if ever
+    size_t next_event_cycles() const { return m_next_event; }
+    
+    //Serial transfers go to the other end of link instead of nowhere. nullptr to unplug.
+    void connect(SerialLink* link);
+    
+    //Everything written to SB
+    SerialOutput& serial_output() { return m_serial_output; }
 
 private:
     /*
@@ -46,36 +60,69 @@ private:
      1 main clock cycle  = 1 / 4194304 = 0.238uS
      
      So 8 bits = 8 * 122uS = 976uS
-     In main clock cycles = 976uS / 0.238uS = 4100 clock cycles
-     4 clock cycles per instruction cycle so 4100/4 = 1025 instr cycles
+     8192Hz is 4194304Hz / 512, so 1 bit = 512 main clock cycles
+     m_cycles counts main clock cycles, 8 bits = 8 * 512 = 4096 clock cycles
     */
+    static const size_t SERIAL_TRANSFER_CYCLES = 4096;
+    
     struct SerialTransfer
     {
-        explicit SerialTransfer(uint8_t v):
-            value(v), cycles(1025)
+        SerialTransfer(uint8_t v, size_t done_at):
+            value(v), done_at(done_at), active(true)
         {}
         
         SerialTransfer():
-            value(0), cycles(-1)
+            value(0), done_at(0), active(false)
         {}
         
-        bool valid() { return cycles != -1; }
+        bool valid() const { return active; }
         
-        int cycles;
         uint8_t value;
-    } m_serial_transfer;
+        size_t done_at;
+        bool active;
+    };
+    //Ours, with the byte sent
+    SerialTransfer m_serial_transfer;
+    //The other end's, with the byte it sent. We only answer it if we're using the external clock.
+    SerialTransfer m_peer_transfer;
+    
+    static const size_t NO_EVENT = size_t(-1);
+    
+    /*DIV and TIMA aren't counted on every tick, they're worked out from the
+     cycle count when read. Tick only does anything once m_next_event (a
+     timer overflow or the end of a serial transfer) is reached.*/
+    void sync_timer(size_t curr_cycles);
+    void schedule();
+    
+    void sync_link(size_t curr_cycles);
+    void check_peer_transfer();
+    bool peer_transfer_due() const;
+    bool serial_waiting() const;
+    void answer_peer_transfer();
+    void finish_serial_transfer();
+    
+    SerialLink* m_link;
+    size_t m_next_sync;
+    size_t m_last_peer_answer;
+    //Heard about after its done_at
+    bool m_peer_transfer_late;
     
     size_t m_cycles;
     bool m_clock_enable;
-    uint8_t m_divider_cnt;
     uint8_t m_time_cont;
-    uint32_t m_timer_countdown_start;
-    uint32_t m_timer_countdown;
-    uint32_t m_divider_countdown;
+    //In clocks, set by TIMECONT
+    size_t m_timer_period;
+    //m_time_cnt is TIMA's value at this cycle, it goes up every m_timer_period after
+    size_t m_timer_base;
+    //DIV goes up every 256 clocks, this is how many had gone by when it was reset
+    size_t m_divider_base;
+    size_t m_next_event;
     uint8_t m_time_mod;
     uint8_t m_time_cnt;
     
-    uint8_t m_serial_data_recieved;
+    //Byte to send before a transfer, byte received after
+    uint8_t m_serial_data;
+    SerialOutput m_serial_output;
     uint8_t m_serial_control;
     
     uint8_t m_interrupt_flags;
@@ -0,0 +1,85 @@
+//
+//  InputLatency.cpp
+//  GameboyEmu
+//
+//  Created by David Spickett on 18/10/2026.
+//  Copyright © 2026 David Spickett. All rights reserved.
+//
+
+#include "InputLatency.hpp"
+#include <algorithm>
+
+InputLatency::InputLatency():
+    m_last_latched(0),
+    m_latches(64),
+    m_sequence(0),
+    m_presented(false),
+    m_presented_frame(0),
+    m_count(0),
+    m_total(Clock::duration::zero()),
+    m_worst(Clock::duration::zero())
+{
+}
+
+uint32_t InputLatency::input_changed()
+{
+    //0 is left for the buttons we start with
+    ++m_sequence;
+    m_input_times[m_sequence % m_input_times.size()] = Clock::now();
+    return m_sequence;
+}
+
+void InputLatency::frame_done(size_t frame_number, uint32_t sequence)
+{
+    if (sequence != m_last_latched)
+    {
+        m_last_latched = sequence;
+        Latch latch = {frame_number, sequence};
+        //If the main thread isn't taking these it isn't presenting either
+        m_latches.push(&latch, 1);
+    }
+}
+
+void InputLatency::presented(size_t frame_number)
+{
+    //Anything that arrived after the last frame was shown belongs to that one
+    match_latches();
+    
+    m_presented = true;
+    m_presented_frame = frame_number;
+    m_presented_time = Clock::now();
+    match_latches();
+}
+
+void InputLatency::match_latches()
+{
+    Latch latch;
+    while (m_latches.pop(&latch, 1))
+    {
+        m_waiting.push_back(latch);
+    }
+    
+    //Frames can be dropped, in which case the input is seen in the next one shown
+    while (m_presented && !m_waiting.empty() &&
+           (m_waiting.front().frame_number <= m_presented_frame))
+    {
+        uint32_t sequence = m_waiting.front().sequence;
+        m_waiting.pop_front();
+        
+        Clock::duration latency = m_presented_time - m_input_times[sequence % m_input_times.size()];
+        ++m_count;
+        m_total += latency;
+        m_worst = std::max(m_worst, latency);
+    }
+}
+
+LatencyStats InputLatency::stats() const
+{
+    typedef std::chrono::duration<double, std::milli> Milliseconds;
+    
+    LatencyStats stats;
+    stats.count = m_count;
+    stats.average_ms = m_count ? (Milliseconds(m_total).count() / m_count) : 0;
+    stats.worst_ms = Milliseconds(m_worst).count();
+    return stats;
+}
@@ -0,0 +1,75 @@
+//
+//  InputLatency.hpp
+//  GameboyEmu
+//
+//  Created by David Spickett on 18/10/2026.
+//  Copyright © 2026 David Spickett. All rights reserved.
+//
+
+#ifndef InputLatency_hpp
+#define InputLatency_hpp
+
+#include <stdint.h>
+#include <stddef.h>
+#include <array>
+#include <chrono>
+#include <deque>
+#include "RingBuffer.hpp"
+
+struct LatencyStats
+{
+    size_t count;
+    double average_ms;
+    double worst_ms;
+};
+
+/*Measures how long a change of input takes to reach the screen. The main
+ thread notes when it sees input change and when it shows a frame, the
+ emulator thread notes which input each frame was drawn with. Input that
+ was latched during a frame is taken to show up at the end of that frame.*/
+class InputLatency
+{
+public:
+    InputLatency();
+    
+    //Main thread, when the host's input changes. Returns the sequence number for it.
+    uint32_t input_changed();
+    //Main thread, after showing a frame
+    void presented(size_t frame_number);
+    
+    //Emulator thread, as each frame finishes with the input it was drawn with
+    void frame_done(size_t frame_number, uint32_t sequence);
+    
+    //Main thread
+    LatencyStats stats() const;
+    
+private:
+    typedef std::chrono::steady_clock Clock;
+    
+    struct Latch
+    {
+        size_t frame_number;
+        uint32_t sequence;
+    };
+    
+    void match_latches();
+    
+    //Emulator thread side
+    uint32_t m_last_latched;
+    RingBuffer<Latch> m_latches;
+    
+    //Main thread side
+    uint32_t m_sequence;
+    //Indexed by sequence, needs to hold any input that could still be waiting to be shown
+    std::array<Clock::time_point, 64> m_input_times;
+    std::deque<Latch> m_waiting;
+    bool m_presented;
+    size_t m_presented_frame;
+    Clock::time_point m_presented_time;
+    
+    size_t m_count;
+    Clock::duration m_total;
+    Clock::duration m_worst;
+};
+
+#endif /* InputLatency_hpp */
@@ -10,45 +10,93 @@
 #include <SDL2/SDL.h>
 #include "Z80.hpp"
 
+namespace
+{
+    //In the order of the bits in InputManager::set_buttons
+    const std::array<int, 8> KEYCODES = {
+        SDL_SCANCODE_RIGHT, SDL_SCANCODE_LEFT, SDL_SCANCODE_UP, SDL_SCANCODE_DOWN,
+        SDL_SCANCODE_X, SDL_SCANCODE_Z, SDL_SCANCODE_RSHIFT, SDL_SCANCODE_RETURN
+    };
+}
+
 InputManager::InputManager():
     m_mode(INVALID),
-    m_joypad_keycodes{SDL_SCANCODE_RIGHT, SDL_SCANCODE_LEFT, SDL_SCANCODE_UP, SDL_SCANCODE_DOWN},
-    m_button_keycodes{SDL_SCANCODE_X, SDL_SCANCODE_Z, SDL_SCANCODE_RSHIFT, SDL_SCANCODE_RETURN}
+    m_buttons(0),
+    m_sequence(0),
+    m_live_input(nullptr),
+    m_live_latched(false)
 {
 }
 
-uint8_t InputManager::get_joy_vaue(InputMode mode, const uint8_t* state)
+uint8_t InputManager::buttons_from_keyboard()
 {
-    auto new_pad_value = 0;
-    if (mode != INVALID)
+    const uint8_t* state = SDL_GetKeyboardState(NULL);
+    uint8_t buttons = 0;
+    for (size_t i=0; i<KEYCODES.size(); ++i)
     {
-        auto button_codes = mode == DIR ? m_joypad_keycodes.begin() : m_button_keycodes.begin();
-        for (auto i=0; i != 4; ++i, ++button_codes)
+        if (state[KEYCODES[i]])
         {
-            //Bit is set if the button is *NOT* held down
-            if (!state[*button_codes])
-            {
-                new_pad_value |= 1<<i;
-            }
+            buttons |= 1<<i;
         }
     }
+    return buttons;
+}
+
+uint8_t InputManager::get_joy_vaue(InputMode mode)
+{
+    auto new_pad_value = 0;
+    if (mode != INVALID)
+    {
+        uint8_t held = mode == DIR ? m_buttons : (m_buttons >> 4);
+        //Bit is set if the button is *NOT* held down
+        new_pad_value = ~held & 0x0f;
+    }
     
     return new_pad_value;
 }
 
-bool InputManager::read_inputs()
+uint8_t InputManager::input_lines()
+{
+    return m_mode == INVALID ? 0x0f : get_joy_vaue(m_mode);
+}
+
+void InputManager::check_interrupt(uint8_t old_lines)
 {
-    //Used to get the console out of a stopped state
-    auto state = SDL_GetKeyboardState(NULL);
-    return (get_joy_vaue(DIR, state) != 0x0f) || (get_joy_vaue(BUTTON, state) != 0x0f);
+    if (old_lines & ~input_lines())
+    {
+        post_int(PIN);
+    }
+}
+
+void InputManager::set_buttons(uint8_t buttons, uint32_t sequence)
+{
+    if (sequence < m_sequence)
+    {
+        return;
+    }
+    
+    uint8_t old_lines = input_lines();
+    m_buttons = buttons;
+    m_sequence = sequence;
+    check_interrupt(old_lines);
 }
 
 uint8_t InputManager::read8(uint16_t addr)
 {
-    return get_joy_vaue(m_mode, SDL_GetKeyboardState(NULL));;
+    if (m_live_input && !m_live_latched)
+    {
+        m_live_latched = true;
+        uint64_t live = m_live_input->load(std::memory_order_acquire);
+        set_buttons(uint8_t(live), uint32_t(live >> 8));
+    }
+    
+    return get_joy_vaue(m_mode);
 }
 
 void InputManager::write8(uint16_t addr, uint8_t value)
 {
+    //Selecting a group with a button held pulls its line low too
+    uint8_t old_lines = input_lines();
     m_mode = static_cast<InputMode>((value >> 4) & 3);
+    check_interrupt(old_lines);
 }
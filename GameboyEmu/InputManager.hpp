@@ -10,6 +10,8 @@
 #define InputManager_hpp
 
 #include "MemoryManager.hpp"
+#include <atomic>
+#include <stdexcept>
 
 class InputManager: public MemoryManager
 {
@@ -22,7 +24,32 @@ public:
     uint16_t read16(uint16_t addr) {throw std::runtime_error("?");}
     void write16(uint16_t addr, uint16_t value) {throw std::runtime_error("?");}
     
-    bool read_inputs();
+    //True if any button is held, used to get the console out of a stopped state
+    bool read_inputs() const { return m_buttons != 0; }
+    
+    /*Held buttons, bits 0-3 are right, left, up, down and 4-7 are A, B,
+     select, start. Set by the emulator thread from input sent to it, once
+     a frame. JOYP reads use this until the next time it's set.
+     
+     Sequence counts how many times the host's input has changed, anything
+     older than what we already have is ignored.*/
+    void set_buttons(uint8_t buttons, uint32_t sequence);
+    //Sequence number of the buttons JOYP reads currently see
+    uint32_t latched_sequence() const { return m_sequence; }
+    
+    /*Instead of waiting for the next frame, pick up the host's input at the
+     first JOYP read of each frame. Live is written by the main thread,
+     make_live_input packs it.*/
+    void set_live_input(const std::atomic<uint64_t>* live) { m_live_input = live; }
+    static uint64_t make_live_input(uint8_t buttons, uint32_t sequence)
+    {
+        return (uint64_t(sequence) << 8) | buttons;
+    }
+    //Call at the start of each frame
+    void new_frame() { m_live_latched = false; }
+    
+    //Only for the main thread, which owns SDL
+    static uint8_t buttons_from_keyboard();
     
     void tick(size_t curr_cycles) {}
     
@@ -34,11 +61,18 @@ private:
         INVALID
     };
     
-    uint8_t get_joy_vaue(InputMode mode, const uint8_t* state);
+    uint8_t get_joy_vaue(InputMode mode);
+    //P10-P13 as the hardware sees them, high if not selected or not held
+    uint8_t input_lines();
+    //Raise the joypad interrupt if any line has gone from high to low
+    void check_interrupt(uint8_t old_lines);
     
-    const std::array<int, 4> m_joypad_keycodes;
-    const std::array<int, 4> m_button_keycodes;
     InputMode m_mode;
+    uint8_t m_buttons;
+    uint32_t m_sequence;
+    
+    const std::atomic<uint64_t>* m_live_input;
+    bool m_live_latched;
 };
 
 #endif /* InputManager_hpp */
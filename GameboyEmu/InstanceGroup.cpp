@@ -0,0 +1,39 @@
+//
+//  InstanceGroup.cpp
+//  GameboyEmu
+//
+//  Created by David Spickett on 18/10/2026.
+//  Copyright © 2026 David Spickett. All rights reserved.
+//
+
+#include "InstanceGroup.hpp"
+#include <algorithm>
+#include "instructions.hpp"
+
+void InstanceGroup::Run(size_t num_steps)
+{
+    if (m_procs.empty())
+    {
+        return;
+    }
+    
+    m_procs[0]->prefetch();
+    
+    while (num_steps)
+    {
+        size_t batch = std::min(m_batch_size, num_steps);
+        
+        for (size_t i=0; i<m_procs.size(); ++i)
+        {
+            m_procs[(i+1) % m_procs.size()]->prefetch();
+            
+            Z80& proc = *m_procs[i];
+            for (size_t step=0; step<batch; ++step)
+            {
+                Step(proc);
+            }
+        }
+        
+        num_steps -= batch;
+    }
+}
@@ -0,0 +1,36 @@
+//
+//  InstanceGroup.hpp
+//  GameboyEmu
+//
+//  Created by David Spickett on 18/10/2026.
+//  Copyright © 2026 David Spickett. All rights reserved.
+//
+
+#ifndef InstanceGroup_hpp
+#define InstanceGroup_hpp
+
+#include <vector>
+#include "Z80.hpp"
+
+/*Runs several emulators on one thread, taking turns a small batch of
+ instructions at a time. Before each batch the next instance in line is
+ prefetched so that its cache misses overlap with this batch's work,
+ instead of stalling the core one instance after another.*/
+class InstanceGroup
+{
+public:
+    explicit InstanceGroup(size_t batch_size=64):
+        m_batch_size(batch_size)
+    {}
+    
+    void Add(Z80& proc) { m_procs.push_back(&proc); }
+    
+    //Step every instance num_steps times
+    void Run(size_t num_steps);
+    
+private:
+    std::vector<Z80*> m_procs;
+    size_t m_batch_size;
+};
+
+#endif /* InstanceGroup_hpp */
@@ -9,6 +9,7 @@
 #include "LCD.hpp"
 #include "utils.hpp"
 #include "Z80.hpp"
+#include "DeferredRenderer.hpp"
 
 namespace
 {
@@ -25,241 +26,104 @@ namespace
     const uint16_t WINPOSX    = 0xff4b;
     
     const uint8_t VBLANK_SCANLINE = 144;
-
-    const int TILE_BYTES        = 16;
-    const int TILE_SIDE         = 8;
-    const int TILES_PER_LINE    = 32;
     
-    inline uint8_t index_to_signed(uint8_t index)
-    {
-        return index + 128;
-    }
+    /*
+     See:
+     http://gameboy.mongenel.com/dmg/gbc_lcdc_timing.txt
+     http://imrannazar.com/GameBoy-Emulation-in-JavaScript:-GPU-Timings
+     
+     4 clocks tick at 4MHz is one 'cycle'. curr_cycles counts clocks,
+     like the timer and sound, so these are in clocks too.
+     
+     Mode 2 = 80  clocks = 20  cycles
+     Mode 3 = 172 clocks = 43  cycles
+     Mode 0 = 204 clocks = 51  cycles
+     Total  = 456 clocks = 114 cycles per line.
+     
+     Mode 1 = 10*456 = 4560 clocks = 1140 cycles
+     
+     */
+    const size_t CYCLES_PER_SCAN_LINE = 456;
+    
+    const size_t CYCLES_MODE_2_OAM_ACCESS  = 80;
+    const size_t CYCLES_MODE_3_BOTH_ACCESS = 172 + CYCLES_MODE_2_OAM_ACCESS;
+    const size_t CYCLES_MODE_0_HBLANK      = 204 + CYCLES_MODE_3_BOTH_ACCESS;
 }
 
-LCD::LCD(int scale_factor):
-m_display(scale_factor),
+LCD::LCD():
 m_last_tick_cycles(0),
+m_next_event_cycles(0),
 m_lcd_line_cycles(0),
+m_frame_count(0),
+m_frame_consumers(FRAME_DISPLAY),
 m_curr_scanline(145),
-m_colours{colour(0xff, 0xff, 0xff), colour(0xb9, 0xb9, 0xb9),
-          colour(0x6b, 0x6b, 0x6b), colour(0x00, 0x00, 0x00)},
 m_lcd_stat(0),
-m_scroll_y(0),
-m_scroll_x(0),
-m_cmpline(0),
-m_winposy(0),
-m_winposx(0)
+m_cmpline(0)
 {
-    init_array(m_bgrd_pal);
-    init_array(m_obj_pal_0);
-    init_array(m_obj_pal_1);
-    init_array(m_data);
-    
     set_mode(VBLANK);
 }
 
-void LCD::set_mode(LCDMode mode)
-{
-    m_lcd_stat = (m_lcd_stat & ~3) | mode;
-}
-
-LCDPalette LCD::make_palette(uint8_t value)
-{
-    LCDPalette ret;
-    for (auto i=0; i<4; ++i)
-    {
-        ret[i] = value & 0x3;
-        value >>= 2;
-    }
-    
-    return ret;
-}
-
-void LCD::update_sprite(uint16_t addr, uint8_t value)
+LCD::~LCD()
 {
-    auto index = (addr-LCD_OAM_START) / SPRITE_INFO_BYTES;
-    m_sprites[index].update(addr, value);
 }
 
-template <typename T>
-void LCD::update_tile_row(uint16_t addr, T value)
+void LCD::start_render_thread()
 {
-    m_tile_rows[tile_index(addr)].update(addr, value);
+    m_deferred.reset(new DeferredRenderer(m_renderer, m_frames));
 }
 
-//Note that tile also means sprite here, colour data is in the same format.
-void LCD::tile_row_to_pixels(
-    TileRow& tile_row, //Precalculated pixel unmapped colour values
-    int startx, //Top left x co-ord of the tile.
-    int starty, //Top left y co-ord of the tile.
-    bool is_sprite, //Set to handle transparancy of colour 0
-    bool flip_x, //Mirror X co-ords
-    const LCDPalette& palette //Colour mapping
-    )
+void LCD::finish_frames()
 {
-    auto row_start = starty*LCD_WIDTH;
-    
-    for (auto shift=(TILE_SIDE-1); shift>= 0; --shift)
+    if (m_deferred)
     {
-        auto shift_diff = flip_x ? shift : (TILE_SIDE-1-shift);
-        auto newx = startx + shift_diff;
-        if ((newx >= LCD_WIDTH) || (newx < 0))
-        {
-            continue;
-        }
-        
-        auto c = tile_row.m_colours[shift];
-        
-        if (is_sprite && c==0)
-        {
-            //Colour 0 is always 'transparent' for sprites
-            continue;
-        }
-        
-        m_display.m_pixel_data[row_start+newx] = m_colours[palette[c]];
+        m_deferred->finish();
     }
 }
 
-void LCD::draw_sprites()
+void LCD::set_mode(LCDMode mode)
 {
-    const int sprite_bytes = 2*m_control_reg.sprite_size;
-    
-    std::for_each(m_sprites.begin(), m_sprites.end(), [=](const Sprite& sprite)
-    {
-        int sprite_row_offset = int(m_curr_scanline) - sprite.y;
-        LCDPalette& palette = sprite.pallete_number ? m_obj_pal_1 : m_obj_pal_0;
-        
-        if (sprite.on_screen(m_curr_scanline, m_control_reg.sprite_size))
-        {
-            //Sprite pixels are stored in the same place as backgound tiles
-            uint16_t tile_offset = sprite.pattern_number;
-            if (m_control_reg.sprite_size == 16)
-            {
-                tile_offset &= ~1;
-            }
-            tile_offset *= sprite_bytes;
-            
-            auto sprite_offset = tile_offset;
-            if (sprite.y_flip)
-            {
-                sprite_offset += (m_control_reg.sprite_size-sprite_row_offset-1)*2;
-            }
-            else
-            {
-                sprite_offset += sprite_row_offset*2;
-            }
-            
-            tile_row_to_pixels(m_tile_rows[sprite_offset/2],
-                               sprite.x, sprite.y + sprite_row_offset,
-                               true,
-                               sprite.x_flip,
-                               palette);
-        }
-    });
+    m_lcd_stat = (m_lcd_stat & ~3) | mode;
 }
 
-void LCD::draw_window()
+LCDPalette LCD::make_palette(uint8_t value)
 {
-    if (m_control_reg.window_display)
+    LCDPalette ret;
+    for (auto i=0; i<4; ++i)
     {
-        if (m_curr_scanline >= m_winposy)
-        {
-            auto x = m_winposx-7;
-            auto tile_index_row = (m_curr_scanline-m_winposy) / TILE_SIDE;
-            auto tile_row_offset = (m_curr_scanline-m_winposy) % TILE_SIDE;
-            
-            for (auto tile_no=0; x<(LCD_WIDTH+TILE_SIDE); x+=TILE_WIDTH, ++tile_no)
-            {
-                auto offset = m_control_reg.window_tile_table_addr+(tile_index_row*TILES_PER_LINE)+tile_no;
-                auto tile_index = m_data[offset];
-                
-                
-                if (m_control_reg.signed_tile_nos)
-                {
-                    tile_index = index_to_signed(tile_index);
-                }
-                
-                uint16_t tile_addr = tile_index*TILE_BYTES;
-                
-                tile_row_to_pixels(
-                   m_tile_rows[(tile_addr + m_control_reg.bgrnd_tile_data_addr + (tile_row_offset*2))/2],
-                   x, m_curr_scanline,
-                   m_control_reg.colour_0_transparent,
-                   false,
-                   m_bgrd_pal);
-            }
-        }
+        ret[i] = value & 0x3;
+        value >>= 2;
     }
+    
+    return ret;
 }
 
-void LCD::draw_background()
+size_t LCD::cycles_to_mode_end() const
 {
-    if (m_control_reg.background_display)
+    size_t mode_end = CYCLES_PER_SCAN_LINE;
+    switch (static_cast<LCDMode>(m_lcd_stat & 3))
     {
-        //There is only one line of tiles we are interested in since we're only doing one scanline
-        //Note that Y wraps
-        const uint16_t tile_row = (uint8_t(m_curr_scanline + m_scroll_y) / TILE_WIDTH);
-        
-        //Then we must start somewhere in that row
-        uint8_t tile_row_offset = (m_scroll_x / TILE_WIDTH) % TILES_PER_LINE;
-        
-        //Which row of pixels within the tile
-        const uint8_t tile_pixel_row = (m_curr_scanline + m_scroll_y) % TILE_WIDTH;
-        
-        for (auto x=0; x<(LCD_WIDTH+TILE_SIDE); x+=TILE_WIDTH, ++tile_row_offset)
-        {
-            if (tile_row_offset >= TILES_PER_LINE)
-            {
-                tile_row_offset %= TILES_PER_LINE;
-            }
-            
-            //Get actual value of index from the table
-            uint8_t tile_index = m_data[m_control_reg.bgrnd_tile_table_addr+(TILES_PER_LINE*tile_row)+tile_row_offset];
-            
-            if (m_control_reg.signed_tile_nos)
-            {
-                tile_index = index_to_signed(tile_index);
-            }
-            
-            //The final address to read pixel data from
-            uint16_t tile_addr = tile_index*TILE_BYTES;
-            
-            auto tile_row_index = (tile_addr + m_control_reg.bgrnd_tile_data_addr + (tile_pixel_row*2))/2;
-            tile_row_to_pixels(
-               m_tile_rows[tile_row_index],
-               x - (m_scroll_x % TILE_WIDTH), m_curr_scanline,
-               false,
-               false,
-               m_bgrd_pal);
-            
-            //The idea being that these pixels are always the full row, that's why we
-            //can incremement x by 8 each time. It gets the pixels before and ahead of x.
-        }
+        case OAM_ACCESS:
+            mode_end = CYCLES_MODE_2_OAM_ACCESS;
+            break;
+        case BOTH_ACCESS:
+            mode_end = CYCLES_MODE_3_BOTH_ACCESS;
+            break;
+        case HBLANK:
+            mode_end = CYCLES_MODE_0_HBLANK;
+            break;
+        case VBLANK:
+            break;
     }
+    
+    return mode_end > m_lcd_line_cycles ? mode_end - m_lcd_line_cycles : 0;
 }
 
 void LCD::tick(size_t curr_cycles)
 {
-    /*
-     See:
-     http://gameboy.mongenel.com/dmg/gbc_lcdc_timing.txt
-     http://imrannazar.com/GameBoy-Emulation-in-JavaScript:-GPU-Timings
-     
-     4 clocks tick at 4MHz is one 'cycle'
-     
-     Mode 2 = 80  clocks = 20  cycles
-     Mode 3 = 172 clocks = 43  cycles
-     Mode 0 = 204 clocks = 51  cycles
-     Total  = 456 clocks = 114 cycles per line.
-     
-     Mode 1 = 10*456 = 4560 clocks = 1140 cycles
-     
-     */
-    const size_t CYCLES_PER_SCAN_LINE = 114;
-    
-    const size_t CYCLES_MODE_2_OAM_ACCESS  = 20;
-    const size_t CYCLES_MODE_3_BOTH_ACCESS = 43 + CYCLES_MODE_2_OAM_ACCESS;
-    const size_t CYCLES_MODE_0_HBLANK      = 51 + CYCLES_MODE_3_BOTH_ACCESS;
+    if (curr_cycles < m_next_event_cycles)
+    {
+        return;
+    }
     
     LCDMode old_mode = static_cast<LCDMode>(m_lcd_stat & 3);
     auto new_mode = old_mode;
@@ -282,18 +146,11 @@ void LCD::tick(size_t curr_cycles)
             if (m_lcd_line_cycles >= CYCLES_MODE_3_BOTH_ACCESS)
             {
                 new_mode = HBLANK;
-                draw_background();
-                draw_window();
-                //TOOD: sprite priority
-                draw_sprites();
                 
-                /*
-                 State machine continues if LCD is off, games like Dr. Mario
-                 disable it during transitions.
-                */
-                if (m_control_reg.lcd_operation)
+                //Skipped frames leave the pixels alone, only the timing runs
+                if (m_frame_consumers)
                 {
-                    m_display.Draw(m_curr_scanline);
+                    draw_line();
                 }
             }
             break;
@@ -304,6 +161,22 @@ void LCD::tick(size_t curr_cycles)
                 if (m_curr_scanline == VBLANK_SCANLINE)
                 {
                     new_mode = VBLANK;
+                    ++m_frame_count;
+                    
+                    /*
+                     State machine continues if LCD is off, games like Dr. Mario
+                     disable it during transitions.
+                    */
+                    bool publish = m_regs.control.lcd_operation &&
+                        (m_frame_consumers & (FRAME_DISPLAY | FRAME_SCREENSHOT));
+                    if (m_deferred)
+                    {
+                        m_deferred->end_frame(publish, m_frame_count);
+                    }
+                    else if (publish)
+                    {
+                        publish_frame();
+                    }
                     /*This interrupt type has a higher priority so it's
                      ok that the post_interrupt further down will be ignored.*/
                     post_int(LCD_VBLANK);
@@ -371,19 +244,43 @@ void LCD::tick(size_t curr_cycles)
     }
     
     m_last_tick_cycles = curr_cycles;
+    m_next_event_cycles = curr_cycles + cycles_to_mode_end();
 }
 
-uint8_t LCD::read8(uint16_t addr)
+void LCD::draw_line()
 {
-    if ((addr >= LCD_MEM_START) && (addr < LCD_BGRND_DATA))
+    if (m_deferred)
     {
-        /*Race Drivin' reads character RAM. I *think* it's waiting for
-         an interrupt routine to fill in the data.*/
-        return m_tile_rows[tile_index(addr)].get(addr);
+        m_deferred->draw_line(m_curr_scanline, m_regs);
     }
-    else if ((addr >= LCD_BGRND_DATA) && (addr < LCD_MEM_END))
+    else
     {
-        return m_data[addr-LCD_BGRND_DATA];
+        m_renderer.draw_line(m_curr_scanline, m_regs);
+    }
+}
+
+void LCD::publish_frame()
+{
+    m_frames.back().frame = m_renderer.frame();
+    m_frames.back().number = m_frame_count;
+    m_frames.publish();
+}
+
+RenderStats LCD::render_stats()
+{
+    return m_deferred ? m_deferred->render_stats() : m_renderer.stats();
+}
+
+uint64_t LCD::frame_hash()
+{
+    return m_deferred ? m_deferred->frame_hash() : ::frame_hash(m_renderer.frame());
+}
+
+uint8_t LCD::read8(uint16_t addr)
+{
+    if ((addr >= LCD_MEM_START) && (addr < LCD_MEM_END))
+    {
+        return m_renderer.read8(addr);
     }
     else if ((addr >= LCD_REGS_START) && (addr < LCD_REGS_END))
     {
@@ -392,19 +289,19 @@ uint8_t LCD::read8(uint16_t addr)
             case CURLINE:
                 return m_curr_scanline;
             case LCDCONTROL:
-                return m_control_reg.read();
+                return m_regs.control.read();
             case LCDSTAT:
                 return m_lcd_stat;
             case SCROLLY:
-                return m_scroll_y;
+                return m_regs.scroll_y;
             case SCROLLX:
-                return m_scroll_x;
+                return m_regs.scroll_x;
             case CMPLINE:
                 return m_cmpline;
             case WINPOSY:
-                return m_winposy;
+                return m_regs.winposy;
             case WINPOSX:
-                return m_winposx;
+                return m_regs.winposx;
             default:
                 throw std::runtime_error("Unknown LCD register read!");
         }
@@ -417,17 +314,14 @@ uint8_t LCD::read8(uint16_t addr)
 
 void LCD::write8(uint16_t addr, uint8_t value)
 {
-    if ((addr >= LCD_MEM_START) && (addr < LCD_BGRND_DATA))
-    {
-        update_tile_row(addr, value);
-    }
-    else if ((addr >= LCD_BGRND_DATA) && (addr < LCD_MEM_END))
-    {
-        m_data[addr-LCD_BGRND_DATA] = value;
-    }
-    else if ((addr >= LCD_OAM_START) && (addr < LCD_OAM_END))
+    if (((addr >= LCD_MEM_START) && (addr < LCD_MEM_END)) ||
+        ((addr >= LCD_OAM_START) && (addr < LCD_OAM_END)))
     {
-        update_sprite(addr, value);
+        m_renderer.write8(addr, value);
+        if (m_deferred)
+        {
+            m_deferred->write8(addr, value);
+        }
     }
     else if ((addr >= LCD_REGS_START) && (addr < LCD_REGS_END))
     {
@@ -435,46 +329,57 @@ void LCD::write8(uint16_t addr, uint8_t value)
         {
             case CURLINE:
                 m_curr_scanline = 0;
+                m_lcd_line_cycles = 0;
                 set_mode(OAM_ACCESS);
+                //Work out when the new mode ends on the next tick
+                m_next_event_cycles = 0;
                 break;
             case LCDCONTROL:
-                m_control_reg.write(value);
-                if (m_control_reg.lcd_operation)
-                {
-                    m_display.Init();
-                }
-                else
+            {
+                bool was_on = m_regs.control.lcd_operation;
+                m_regs.control.write(value);
+                if (was_on && !m_regs.control.lcd_operation)
                 {
-                    m_display.Clear();
+                    //Show a blank screen while it's off
+                    if (m_deferred)
+                    {
+                        m_deferred->blank(m_frame_count);
+                    }
+                    else
+                    {
+                        m_renderer.blank();
+                        publish_frame();
+                    }
                 }
                 break;
+            }
             case LCDSTAT:
                 //Mode bits are read only
                 m_lcd_stat = (m_lcd_stat & 3) | (value & ~3);
                 break;
             case BGRDPAL:
-                m_bgrd_pal = make_palette(value);
+                m_regs.bgrd_pal = make_palette(value);
                 break;
             case OBJPAL0:
-                m_obj_pal_0 = make_palette(value);
+                m_regs.obj_pal_0 = make_palette(value);
                 break;
             case OBJPAL1:
-                m_obj_pal_1 = make_palette(value);
+                m_regs.obj_pal_1 = make_palette(value);
                 break;
             case SCROLLY:
-                m_scroll_y = value;
+                m_regs.scroll_y = value;
                 break;
             case SCROLLX:
-                m_scroll_x = value;
+                m_regs.scroll_x = value;
                 break;
             case CMPLINE:
                 m_cmpline = value;
                 break;
             case WINPOSY:
-                m_winposy = value;
+                m_regs.winposy = value;
                 break;
             case WINPOSX:
-                m_winposx = value;
+                m_regs.winposx = value;
                 break;
             default:
                 throw std::runtime_error("Unknown LCD register write!");
@@ -491,8 +396,7 @@ uint16_t LCD::read16(uint16_t addr)
     //Don't allow reads of OAM or character RMAM
     if ((addr >= LCD_BGRND_DATA) && (addr < LCD_MEM_END))
     {
-        uint16_t offset = addr-LCD_BGRND_DATA;
-        uint16_t ret = (uint16_t(m_data[offset+1]) << 8) | uint16_t(m_data[offset]);
+        uint16_t ret = (uint16_t(m_renderer.read8(addr+1)) << 8) | uint16_t(m_renderer.read8(addr));
         return ret;
     }
     else
@@ -501,22 +405,25 @@ uint16_t LCD::read16(uint16_t addr)
     }
 }
 
-void LCD::write16(uint16_t addr, uint16_t value)
+void LCD::oam_dma(const uint8_t* data)
 {
-    if ((addr >= LCD_MEM_START) && (addr < LCD_BGRND_DATA))
-    {
-        update_tile_row(addr, value);
-    }
-    else if ((addr >= LCD_BGRND_DATA) && (addr < LCD_MEM_END))
+    m_renderer.write_oam(data);
+    if (m_deferred)
     {
-        uint16_t offset = addr-LCD_BGRND_DATA;
-        m_data[offset] = value & 0xff;
-        m_data[offset+1] = (value >> 8) & 0xff;
+        m_deferred->write_oam(data);
     }
-    else if ((addr >= LCD_OAM_START) && (addr < LCD_OAM_END))
+}
+
+void LCD::write16(uint16_t addr, uint16_t value)
+{
+    if (((addr >= LCD_MEM_START) && (addr < LCD_MEM_END)) ||
+        ((addr >= LCD_OAM_START) && (addr < LCD_OAM_END)))
     {
-        update_sprite(addr, value & 0xff);
-        update_sprite(addr+1, (value >> 8) & 0xff);
+        m_renderer.write16(addr, value);
+        if (m_deferred)
+        {
+            m_deferred->write16(addr, value);
+        }
     }
     else
     {
@@ -0,0 +1,69 @@
+//
+//  LCDFrame.cpp
+//  GameboyEmu
+//
+//  Created by David Spickett on 18/10/2026.
+//  Copyright © 2026 David Spickett. All rights reserved.
+//
+
+#include "LCDFrame.hpp"
+#include <string.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+uint64_t frame_hash(const LCDFrame& frame)
+{
+    uint64_t hash = 0xcbf29ce484222325;
+    for (uint8_t b : frame)
+    {
+        hash = (hash ^ b) * 0x100000001b3;
+    }
+    return hash;
+}
+
+LCDShades default_shades()
+{
+    LCDShades shades = {{
+        make_pixel(0xff, 0xff, 0xff), make_pixel(0xb9, 0xb9, 0xb9),
+        make_pixel(0x6b, 0x6b, 0x6b), make_pixel(0x00, 0x00, 0x00)
+    }};
+    return shades;
+}
+
+FrameExpander::FrameExpander(const LCDShades& shades)
+{
+    set_shades(shades);
+}
+
+void FrameExpander::set_shades(const LCDShades& shades)
+{
+    for (size_t b=0; b<m_table.size(); ++b)
+    {
+        for (size_t i=0; i<LCD_PIXELS_PER_BYTE; ++i)
+        {
+            m_table[b][i] = shades[(b >> (i*2)) & 3];
+        }
+    }
+}
+
+void FrameExpander::expand(const LCDFrame& frame, uint32_t* out, size_t pitch) const
+{
+    const size_t bytes_per_row = LCD_WIDTH/LCD_PIXELS_PER_BYTE;
+    const uint8_t* in = frame.data();
+    
+    for (size_t y=0; y<LCD_HEIGHT; ++y)
+    {
+        uint32_t* row = reinterpret_cast<uint32_t*>(reinterpret_cast<uint8_t*>(out) + y*pitch);
+        for (size_t i=0; i<bytes_per_row; ++i, ++in, row+=LCD_PIXELS_PER_BYTE)
+        {
+            //Each byte becomes one 16 byte store
+#if defined(__SSE2__)
+            __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(m_table[*in].data()));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(row), pixels);
+#else
+            memcpy(row, m_table[*in].data(), sizeof(m_table[*in]));
+#endif
+        }
+    }
+}
@@ -0,0 +1,65 @@
+//
+//  LCDFrame.hpp
+//  GameboyEmu
+//
+//  Created by David Spickett on 18/10/2026.
+//  Copyright © 2026 David Spickett. All rights reserved.
+//
+
+#ifndef LCDFrame_hpp
+#define LCDFrame_hpp
+
+#include <stdint.h>
+#include <stddef.h>
+#include <array>
+
+const size_t LCD_WIDTH      = 160;
+const size_t LCD_HEIGHT     = 144;
+
+/*A frame as the shade of each pixel, 0 (white) to 3 (black). 2 bits per
+ pixel, 4 to a byte with the leftmost in the lowest bits. Only the display
+ turns these into colours.*/
+const size_t LCD_PIXELS_PER_BYTE = 4;
+using LCDFrame = std::array<uint8_t, (LCD_WIDTH*LCD_HEIGHT)/LCD_PIXELS_PER_BYTE>;
+
+//A finished frame on its way to the display
+struct PublishedFrame
+{
+    PublishedFrame(): frame(), number(0) {}
+    
+    LCDFrame frame;
+    //The LCD's frame_count() when it was finished
+    size_t number;
+};
+
+//FNV-1a of a frame, for checking that frames haven't changed
+uint64_t frame_hash(const LCDFrame& frame);
+
+//Pixels for the display are packed ARGB8888
+inline uint32_t make_pixel(uint8_t r, uint8_t g, uint8_t b)
+{
+    return (0xffu << 24) | (uint32_t(r) << 16) | (uint32_t(g) << 8) | b;
+}
+
+//The pixel to show for each shade
+using LCDShades = std::array<uint32_t, 4>;
+LCDShades default_shades();
+
+//Turns frames into pixels, 16 bytes at a time with SSE2 if we have it
+class FrameExpander
+{
+public:
+    explicit FrameExpander(const LCDShades& shades);
+    
+    //Swapping the shades rebuilds the table, there is no per pixel lookup
+    void set_shades(const LCDShades& shades);
+    
+    //Writes LCD_HEIGHT rows of LCD_WIDTH pixels, pitch is in bytes
+    void expand(const LCDFrame& frame, uint32_t* out, size_t pitch) const;
+    
+private:
+    //The 4 pixels for every possible byte of a frame
+    std::array<std::array<uint32_t, LCD_PIXELS_PER_BYTE>, 256> m_table;
+};
+
+#endif /* LCDFrame_hpp */
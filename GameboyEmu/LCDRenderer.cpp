@@ -0,0 +1,406 @@
+//
+//  LCDRenderer.cpp
+//  GameboyEmu
+//
+//  Created by David Spickett on 18/10/2026.
+//  Copyright © 2026 David Spickett. All rights reserved.
+//
+
+#include "LCDRenderer.hpp"
+#include "utils.hpp"
+#include <cstring>
+#include <algorithm>
+
+namespace
+{
+    const int TILE_BYTES        = 16;
+    const int TILE_SIDE         = 8;
+    const int TILES_PER_LINE    = 32;
+    const int MAP_BYTES         = TILES_PER_LINE*TILES_PER_LINE;
+    
+    //Map cache entries that need drawing
+    const uint16_t NO_TILE = 0xffff;
+    
+    inline uint8_t index_to_signed(uint8_t index)
+    {
+        return index + 128;
+    }
+}
+
+LCDRenderer::LCDRenderer():
+m_vram_version(1),
+m_oam_version(1),
+m_sprites_dirty(false),
+m_curr_scanline(0)
+{
+    init_array(m_data);
+    init_array(m_pixel_data);
+    init_array(m_frame);
+    init_array(m_tile_versions);
+    init_array(m_oam);
+    for (auto& cache : m_map_caches)
+    {
+        init_array(cache.pixels);
+        cache.tiles.fill(NO_TILE);
+        init_array(cache.versions);
+        init_array(cache.rows_checked);
+        init_array(cache.rows_tile_data);
+        init_array(cache.rows_version);
+    }
+}
+
+void LCDRenderer::update_sprite(uint16_t addr, uint8_t value)
+{
+    //Games copy OAM every frame, usually with the same values
+    uint8_t& current = m_oam[addr-LCD_OAM_START];
+    if (current == value)
+    {
+        return;
+    }
+    current = value;
+    ++m_oam_version;
+    m_sprites_dirty = true;
+}
+
+void LCDRenderer::write_oam(const uint8_t* data)
+{
+    if (std::memcmp(m_oam.data(), data, m_oam.size()) == 0)
+    {
+        return;
+    }
+    std::memcpy(m_oam.data(), data, m_oam.size());
+    ++m_oam_version;
+    m_sprites_dirty = true;
+}
+
+void LCDRenderer::decode_sprites()
+{
+    for (size_t offset=0; offset<m_oam.size(); ++offset)
+    {
+        m_sprites[offset / SPRITE_INFO_BYTES].update(offset, m_oam[offset]);
+    }
+    m_sprites_dirty = false;
+}
+
+template <typename T>
+void LCDRenderer::update_tile_row(uint16_t addr, T value)
+{
+    auto index = tile_index(addr);
+    m_tile_rows[index].update(addr, value);
+    ++m_tile_versions[index/TILE_SIDE];
+    ++m_vram_version;
+}
+
+/*Returns a row of the map's pixels, first redrawing any tiles on that row
+ whose tile number, tile data or tile data select has changed.*/
+const uint8_t* LCDRenderer::map_row(uint16_t map_addr, uint8_t y)
+{
+    MapCache& cache = m_map_caches[map_addr / MAP_BYTES];
+    const uint8_t tile_row = y / TILE_SIDE;
+    const uint8_t* pixels = &cache.pixels[y * MAP_SIDE];
+    
+    if ((cache.rows_checked[tile_row] == m_vram_version) &&
+        (cache.rows_tile_data[tile_row] == m_regs.control.bgrnd_tile_data_addr))
+    {
+        return pixels;
+    }
+    cache.rows_checked[tile_row] = m_vram_version;
+    cache.rows_tile_data[tile_row] = m_regs.control.bgrnd_tile_data_addr;
+    
+    const size_t first_entry = tile_row * TILES_PER_LINE;
+    for (size_t entry=first_entry; entry<(first_entry+TILES_PER_LINE); ++entry)
+    {
+        uint8_t tile_index = m_data[map_addr+entry];
+        if (m_regs.control.signed_tile_nos)
+        {
+            tile_index = index_to_signed(tile_index);
+        }
+        uint16_t tile = (tile_index*TILE_BYTES + m_regs.control.bgrnd_tile_data_addr) / TILE_BYTES;
+        
+        if ((cache.tiles[entry] == tile) && (cache.versions[entry] == m_tile_versions[tile]))
+        {
+            continue;
+        }
+        ++cache.rows_version[tile_row];
+        cache.tiles[entry] = tile;
+        cache.versions[entry] = m_tile_versions[tile];
+        
+        uint8_t* dest = &cache.pixels[(entry / TILES_PER_LINE) * TILE_SIDE * MAP_SIDE +
+                                      (entry % TILES_PER_LINE) * TILE_SIDE];
+        for (auto row=0; row<TILE_SIDE; ++row, dest+=MAP_SIDE)
+        {
+            const TileRow& tile_row = m_tile_rows[tile*TILE_SIDE + row];
+            for (auto x=0; x<TILE_SIDE; ++x)
+            {
+                //Bit 7 is the leftmost pixel
+                dest[x] = tile_row.m_colours[TILE_SIDE-1-x];
+            }
+        }
+    }
+    
+    return pixels;
+}
+
+uint32_t LCDRenderer::map_row_version(uint16_t map_addr, uint8_t y)
+{
+    map_row(map_addr, y);
+    return m_map_caches[map_addr / MAP_BYTES].rows_version[y / TILE_SIDE];
+}
+
+LineSignature LCDRenderer::line_signature()
+{
+    LineSignature sig;
+    sig.valid = true;
+    sig.lcdc = m_regs.control.read();
+    sig.scroll_y = m_regs.scroll_y;
+    sig.scroll_x = m_regs.scroll_x;
+    sig.winposy = m_regs.winposy;
+    sig.winposx = m_regs.winposx;
+    sig.bgrd_pal = m_regs.bgrd_pal;
+    sig.obj_pal_0 = m_regs.obj_pal_0;
+    sig.obj_pal_1 = m_regs.obj_pal_1;
+    
+    if (m_regs.control.background_display)
+    {
+        sig.bgrd_row_version = map_row_version(m_regs.control.bgrnd_tile_table_addr,
+                                               m_curr_scanline + m_regs.scroll_y);
+    }
+    if (m_regs.control.window_display && (m_curr_scanline >= m_regs.winposy))
+    {
+        sig.window_row_version = map_row_version(m_regs.control.window_tile_table_addr,
+                                                 m_curr_scanline - m_regs.winposy);
+    }
+    
+    sig.oam_version = m_oam_version;
+    for (auto& sprite : m_sprites)
+    {
+        if (sprite.on_screen(m_curr_scanline, m_regs.control.sprite_size))
+        {
+            //Which tiles sprites use isn't tracked, so any VRAM write counts
+            sig.sprite_tiles_version = m_vram_version;
+            break;
+        }
+    }
+    
+    return sig;
+}
+
+//Note that tile also means sprite here, colour data is in the same format.
+void LCDRenderer::tile_row_to_pixels(
+    TileRow& tile_row, //Precalculated pixel unmapped colour values
+    int startx, //Top left x co-ord of the tile.
+    int starty, //Top left y co-ord of the tile.
+    bool is_sprite, //Set to handle transparancy of colour 0
+    bool flip_x, //Mirror X co-ords
+    const LCDPalette& palette //Colour mapping
+    )
+{
+    auto row_start = starty*LCD_WIDTH;
+    
+    for (auto shift=(TILE_SIDE-1); shift>= 0; --shift)
+    {
+        auto shift_diff = flip_x ? shift : (TILE_SIDE-1-shift);
+        auto newx = startx + shift_diff;
+        if ((newx >= int(LCD_WIDTH)) || (newx < 0))
+        {
+            continue;
+        }
+        
+        auto c = tile_row.m_colours[shift];
+        
+        if (is_sprite && c==0)
+        {
+            //Colour 0 is always 'transparent' for sprites
+            continue;
+        }
+        
+        m_pixel_data[row_start+newx] = palette[c];
+    }
+}
+
+void LCDRenderer::draw_sprites()
+{
+    std::for_each(m_sprites.begin(), m_sprites.end(), [=](const Sprite& sprite)
+    {
+        int sprite_row_offset = int(m_curr_scanline) - sprite.y;
+        const LCDPalette& palette = sprite.pallete_number ? m_regs.obj_pal_1 : m_regs.obj_pal_0;
+        
+        if (sprite.on_screen(m_curr_scanline, m_regs.control.sprite_size))
+        {
+            //Sprite pixels are stored in the same place as backgound tiles
+            uint16_t tile_offset = sprite.pattern_number;
+            if (m_regs.control.sprite_size == 16)
+            {
+                //The top half's tile then the bottom half's
+                tile_offset &= ~1;
+            }
+            tile_offset *= TILE_BYTES;
+            
+            auto sprite_offset = tile_offset;
+            if (sprite.y_flip)
+            {
+                sprite_offset += (m_regs.control.sprite_size-sprite_row_offset-1)*2;
+            }
+            else
+            {
+                sprite_offset += sprite_row_offset*2;
+            }
+            
+            tile_row_to_pixels(m_tile_rows[sprite_offset/2],
+                               sprite.x, sprite.y + sprite_row_offset,
+                               true,
+                               sprite.x_flip,
+                               palette);
+        }
+    });
+}
+
+void LCDRenderer::draw_window()
+{
+    if (m_regs.control.window_display)
+    {
+        if (m_curr_scanline >= m_regs.winposy)
+        {
+            const int startx = m_regs.winposx-7;
+            const uint8_t* row = map_row(m_regs.control.window_tile_table_addr, m_curr_scanline-m_regs.winposy);
+            const LCDPalette& palette = m_regs.bgrd_pal;
+            uint8_t* pixels = &m_pixel_data[m_curr_scanline*LCD_WIDTH];
+            
+            for (int x=std::max(startx, 0); x<int(LCD_WIDTH); ++x)
+            {
+                auto c = row[x-startx];
+                //Not a mistake, the window's colour 0 is see through when sprites are off
+                if (m_regs.control.colour_0_transparent && c==0)
+                {
+                    continue;
+                }
+                pixels[x] = palette[c];
+            }
+        }
+    }
+}
+
+void LCDRenderer::draw_background()
+{
+    if (m_regs.control.background_display)
+    {
+        //Both X and Y wrap around the map
+        const uint8_t* row = map_row(m_regs.control.bgrnd_tile_table_addr, m_curr_scanline + m_regs.scroll_y);
+        const LCDPalette& palette = m_regs.bgrd_pal;
+        uint8_t* pixels = &m_pixel_data[m_curr_scanline*LCD_WIDTH];
+        const uint8_t scroll_x = m_regs.scroll_x;
+        
+        for (size_t x=0; x<LCD_WIDTH; ++x)
+        {
+            pixels[x] = palette[row[uint8_t(scroll_x + x)]];
+        }
+    }
+}
+
+void LCDRenderer::set_line(uint8_t line, const LCDRegisters& regs)
+{
+    m_curr_scanline = line;
+    m_regs = regs;
+    
+    if (m_sprites_dirty)
+    {
+        decode_sprites();
+    }
+}
+
+void LCDRenderer::draw_line(uint8_t line, const LCDRegisters& regs)
+{
+    set_line(line, regs);
+    
+    /*Drawing only ever writes to this line's pixels, so if nothing it
+     depends on has changed it would write exactly what's there already.*/
+    LineSignature sig = line_signature();
+    LineSignature& last = m_line_signatures[line];
+    if (sig == last)
+    {
+        ++m_stats.lines_reused;
+        return;
+    }
+    last = sig;
+    ++m_stats.lines_drawn;
+    
+    draw_background();
+    draw_window();
+    //TOOD: sprite priority
+    draw_sprites();
+    pack_line();
+}
+
+void LCDRenderer::pack_line()
+{
+    const uint8_t* pixels = &m_pixel_data[m_curr_scanline*LCD_WIDTH];
+    uint8_t* packed = &m_frame[m_curr_scanline*(LCD_WIDTH/LCD_PIXELS_PER_BYTE)];
+    
+    for (size_t x=0; x<LCD_WIDTH; x+=LCD_PIXELS_PER_BYTE, ++packed)
+    {
+        *packed = pixels[x] | (pixels[x+1] << 2) | (pixels[x+2] << 4) | (pixels[x+3] << 6);
+    }
+}
+
+void LCDRenderer::blank()
+{
+    init_array(m_pixel_data);
+    init_array(m_frame);
+    m_line_signatures.fill(LineSignature());
+}
+
+uint8_t LCDRenderer::read8(uint16_t addr)
+{
+    if (addr < LCD_BGRND_DATA)
+    {
+        /*Race Drivin' reads character RAM. I *think* it's waiting for
+         an interrupt routine to fill in the data.*/
+        return m_tile_rows[tile_index(addr)].get(addr);
+    }
+    return m_data[addr-LCD_BGRND_DATA];
+}
+
+void LCDRenderer::write8(uint16_t addr, uint8_t value)
+{
+    //Writes that don't change anything don't bump the versions, so lines can still be reused
+    if (addr < LCD_BGRND_DATA)
+    {
+        if (m_tile_rows[tile_index(addr)].get(addr) != value)
+        {
+            update_tile_row(addr, value);
+        }
+    }
+    else if (addr < LCD_MEM_END)
+    {
+        uint8_t& current = m_data[addr-LCD_BGRND_DATA];
+        if (current != value)
+        {
+            current = value;
+            ++m_vram_version;
+        }
+    }
+    else
+    {
+        update_sprite(addr, value);
+    }
+}
+
+void LCDRenderer::write16(uint16_t addr, uint16_t value)
+{
+    if (addr < LCD_BGRND_DATA)
+    {
+        update_tile_row(addr, value);
+    }
+    else if (addr < LCD_MEM_END)
+    {
+        uint16_t offset = addr-LCD_BGRND_DATA;
+        m_data[offset] = value & 0xff;
+        m_data[offset+1] = (value >> 8) & 0xff;
+        ++m_vram_version;
+    }
+    else
+    {
+        update_sprite(addr, value & 0xff);
+        update_sprite(addr+1, (value >> 8) & 0xff);
+    }
+}
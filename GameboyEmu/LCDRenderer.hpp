@@ -0,0 +1,345 @@
+//
+//  LCDRenderer.hpp
+//  GameboyEmu
+//
+//  Created by David Spickett on 18/10/2026.
+//  Copyright © 2026 David Spickett. All rights reserved.
+//
+
+#ifndef LCDRenderer_hpp
+#define LCDRenderer_hpp
+
+#include "MemoryManager.hpp"
+#include "LCDFrame.hpp"
+#include "utils.hpp"
+
+const int TILE_WIDTH        = 8;
+const int SPRITE_INFO_BYTES = 4;
+
+//Maps colour numbers to shades
+using LCDPalette = std::array<uint8_t, 4>;
+using OAMData = std::array<uint8_t, LCD_OAM_END-LCD_OAM_START>;
+using LCDData = std::array<uint8_t, LCD_MEM_END-LCD_BGRND_DATA>;
+
+struct Sprite
+{
+    Sprite():
+        x(-999), y(-999), pattern_number(0), priority(false),
+        y_flip(false), x_flip(false), pallete_number(false)
+    {}
+    
+    void update(uint16_t addr, uint8_t value)
+    {
+        switch (addr % SPRITE_INFO_BYTES)
+        {
+            case 0:
+                y = int(value) - 16;
+                break;
+            case 1:
+                x = int(value) - TILE_WIDTH;
+                break;
+            case 2:
+                pattern_number = value;
+                break;
+            case 3:
+                priority       = value & (1<<7);
+                y_flip         = value & (1<<6);
+                x_flip         = value & (1<<5);
+                pallete_number = value & (1<<4);
+                break;
+        }
+    }
+    
+    bool on_screen(uint8_t curr_scanline, int sprite_height) const
+    {
+        return (curr_scanline >= y) &&
+            (curr_scanline < (y+sprite_height)) && (x > -TILE_WIDTH);
+    }
+    
+    int x;
+    int y;
+    uint8_t pattern_number;
+    bool priority;
+    bool y_flip;
+    bool x_flip;
+    bool pallete_number;
+    
+    std::string to_str()
+    {
+        return formatted_string("Sprite at X:%d Y:%x priority:%d xflip:%d yflip:%d palettenum:%d",
+                                x, y, priority, x_flip,
+                                y_flip, pallete_number);
+    }
+};
+
+using LCDSprites = std::array<Sprite, 40>;
+
+struct TileRow
+{
+    TileRow():
+        m_colours{0, 0, 0, 0, 0, 0, 0, 0},
+        m_lsbs(0),
+        m_msbs(0)
+    {}
+    std::array<uint8_t, 8> m_colours;
+    
+    void update(uint16_t addr, uint16_t value)
+    {
+        m_lsbs = value;
+        m_msbs = value >> 8;
+        _update();
+    }
+    
+    uint8_t get(uint16_t addr)
+    {
+        return addr & 1 ? m_msbs : m_lsbs;
+    }
+    
+    void update(uint16_t addr, uint8_t value)
+    {
+        if (addr & 1)
+        {
+            m_msbs = value;
+        }
+        else
+        {
+            m_lsbs = value;
+        }
+        _update();
+    }
+private:
+    void _update()
+    {
+        for (auto shift=0; shift<8; ++shift)
+        {
+            auto lsb = (m_lsbs >> shift) & 1;
+            auto msb = (m_msbs >> shift) & 1;
+            m_colours[shift] = (msb << 1) | lsb;
+        }
+    }
+    
+private:
+    uint8_t m_lsbs;
+    uint8_t m_msbs;
+};
+
+using TileRows = std::array<TileRow, (LCD_BGRND_DATA-LCD_MEM_START)/2>;
+
+const size_t NUM_TILES = (LCD_BGRND_DATA-LCD_MEM_START)/16;
+//Pixels across a background map, they are 32x32 tiles
+const size_t MAP_SIDE  = 256;
+const size_t MAP_TILES = MAP_SIDE/TILE_WIDTH;
+
+/*A whole background map drawn out as colour numbers, before the palette is
+ applied. Each entry remembers the tile it was drawn from and that tile's
+ version, so it is only redrawn when either changes. Rows of tiles remember
+ the VRAM version they were last checked at, so when nothing has been
+ written they are used as is.*/
+struct MapCache
+{
+    std::array<uint8_t, MAP_SIDE*MAP_SIDE> pixels;
+    std::array<uint16_t, MAP_TILES*MAP_TILES> tiles;
+    std::array<uint32_t, MAP_TILES*MAP_TILES> versions;
+    std::array<uint32_t, MAP_TILES> rows_checked;
+    std::array<uint16_t, MAP_TILES> rows_tile_data;
+    //Bumped when any tile in the row is redrawn
+    std::array<uint32_t, MAP_TILES> rows_version;
+};
+
+struct LCDControlReg
+{
+    LCDControlReg():
+        m_value(0)
+    {}
+    
+    uint8_t read() const
+    {
+        return m_value;
+    }
+    
+    void write(uint8_t value)
+    {
+        m_value=value;
+        
+        lcd_operation          = m_value & (1<<7);
+        window_tile_table_addr = (m_value & (1<<6)) ? 0x9C00-LCD_BGRND_DATA : 0x9800-LCD_BGRND_DATA;
+        window_display         = m_value & (1<<5);
+        bgrnd_tile_data_addr   = (m_value & (1<<4)) ? 0x8000-LCD_MEM_START : 0x8800-LCD_MEM_START;
+        bgrnd_tile_table_addr  = (m_value & (1<<3)) ? 0x9c00-LCD_BGRND_DATA : 0x9800-LCD_BGRND_DATA;
+        sprite_size            = (m_value & (1<<2)) ? 16 : 8;
+        colour_0_transparent   = (m_value & (1<<1)) == 0;
+        background_display     = (m_value) & 1;
+        signed_tile_nos        = (m_value & (1<<4)) == 0;
+    }
+    
+    bool lcd_operation;
+    uint16_t window_tile_table_addr;
+    bool window_display;
+    uint16_t bgrnd_tile_data_addr;
+    uint16_t bgrnd_tile_table_addr;
+    uint8_t sprite_size;
+    bool colour_0_transparent;
+    bool background_display;
+    bool signed_tile_nos;
+    
+private:
+    uint8_t m_value;
+};
+
+//The registers that scanlines are drawn with
+struct LCDRegisters
+{
+    LCDRegisters():
+        scroll_y(0), scroll_x(0), winposy(0), winposx(0)
+    {
+        init_array(bgrd_pal);
+        init_array(obj_pal_0);
+        init_array(obj_pal_1);
+    }
+    
+    LCDControlReg control;
+    uint8_t scroll_y;
+    uint8_t scroll_x;
+    uint8_t winposy;
+    uint8_t winposx;
+    LCDPalette bgrd_pal;
+    LCDPalette obj_pal_0;
+    LCDPalette obj_pal_1;
+};
+
+/*Everything that goes into drawing a scanline. When a line's signature is the
+ same as the last time it was drawn, the pixels already there are correct.*/
+struct LineSignature
+{
+    LineSignature():
+        valid(false), lcdc(0), scroll_y(0), scroll_x(0), winposy(0), winposx(0),
+        bgrd_row_version(0), window_row_version(0), oam_version(0), sprite_tiles_version(0)
+    {
+        init_array(bgrd_pal);
+        init_array(obj_pal_0);
+        init_array(obj_pal_1);
+    }
+    
+    bool operator==(const LineSignature& other) const
+    {
+        return valid && other.valid &&
+            (lcdc == other.lcdc) &&
+            (scroll_y == other.scroll_y) && (scroll_x == other.scroll_x) &&
+            (winposy == other.winposy) && (winposx == other.winposx) &&
+            (bgrd_pal == other.bgrd_pal) &&
+            (obj_pal_0 == other.obj_pal_0) && (obj_pal_1 == other.obj_pal_1) &&
+            (bgrd_row_version == other.bgrd_row_version) &&
+            (window_row_version == other.window_row_version) &&
+            (oam_version == other.oam_version) &&
+            (sprite_tiles_version == other.sprite_tiles_version);
+    }
+    
+    bool valid;
+    uint8_t lcdc;
+    uint8_t scroll_y;
+    uint8_t scroll_x;
+    uint8_t winposy;
+    uint8_t winposx;
+    LCDPalette bgrd_pal;
+    LCDPalette obj_pal_0;
+    LCDPalette obj_pal_1;
+    uint32_t bgrd_row_version;
+    uint32_t window_row_version;
+    uint32_t oam_version;
+    //VRAM version if there are sprites on the line, 0 if not
+    uint32_t sprite_tiles_version;
+};
+
+struct RenderStats
+{
+    RenderStats():
+        lines_drawn(0), lines_reused(0)
+    {}
+    
+    size_t lines_drawn;
+    //Lines left as they were because nothing had changed
+    size_t lines_reused;
+};
+
+/*Holds VRAM and OAM and draws scanlines from them into a frame. It knows
+ nothing about LCD timing, so it can be run on another thread from a copy
+ of the registers.*/
+class LCDRenderer
+{
+    public:
+        LCDRenderer();
+    
+        //Addresses are in VRAM or OAM, the LCD checks them
+        uint8_t read8(uint16_t addr);
+        void write8(uint16_t addr, uint8_t value);
+        void write16(uint16_t addr, uint16_t value);
+        //All of OAM at once, from an OAM DMA
+        void write_oam(const uint8_t* data);
+    
+        void draw_line(uint8_t line, const LCDRegisters& regs);
+    
+        //Public for benchmarking, these draw the line last passed to set_line
+        void set_line(uint8_t line, const LCDRegisters& regs);
+        void draw_background();
+        void draw_sprites();
+        void draw_window();
+    
+        //Fill with white, shown while the LCD is off
+        void blank();
+    
+        const LCDFrame& frame() const { return m_frame; }
+    
+        const RenderStats& stats() const { return m_stats; }
+    
+    private:
+        //Drawn to a byte per pixel, then each line is packed into m_frame
+        std::array<uint8_t, LCD_WIDTH*LCD_HEIGHT> m_pixel_data;
+        LCDFrame m_frame;
+        void pack_line();
+    
+        LCDData m_data;
+        LCDSprites m_sprites;
+        TileRows m_tile_rows;
+    
+        //One per map (0x9800 and 0x9c00), shared by the background and window
+        std::array<MapCache, 2> m_map_caches;
+        //Bumped on every write to a tile
+        std::array<uint32_t, NUM_TILES> m_tile_versions;
+        //Bumped on every write to tiles or maps
+        uint32_t m_vram_version;
+        //Bumped on every write to OAM
+        uint32_t m_oam_version;
+        OAMData m_oam;
+        //m_sprites are decoded from m_oam when the next line is drawn, not on every write
+        bool m_sprites_dirty;
+        void decode_sprites();
+    
+        //What each line was last drawn from
+        std::array<LineSignature, LCD_HEIGHT> m_line_signatures;
+        RenderStats m_stats;
+        LineSignature line_signature();
+        uint32_t map_row_version(uint16_t map_addr, uint8_t y);
+        const uint8_t* map_row(uint16_t map_addr, uint8_t y);
+    
+        //The line being drawn
+        uint8_t m_curr_scanline;
+        LCDRegisters m_regs;
+    
+        void tile_row_to_pixels(
+            TileRow& tile_row,
+            int startx, int starty,
+            bool is_sprite,
+            bool flip_x,
+            const LCDPalette& palette);
+    
+        size_t tile_index(uint16_t addr)
+        {
+            return (addr - LCD_MEM_START)/2;
+        }
+    
+        void update_sprite(uint16_t addr, uint8_t value);
+        template <typename T>
+        void update_tile_row(uint16_t addr, T value);
+};
+
+#endif /* LCDRenderer_hpp */
@@ -0,0 +1,129 @@
+//
+//  LinkCable.cpp
+//  GameboyEmu
+//
+//  Created by David Spickett on 18/10/2026.
+//  Copyright © 2026 David Spickett. All rights reserved.
+//
+
+#include "LinkCable.hpp"
+#include <thread>
+#include <stdexcept>
+
+namespace
+{
+    const size_t DISCONNECTED = size_t(-1);
+    const int NO_REPLY = -1;
+    
+    /*A transfer takes 4096 clocks from start to finish. Neither end gets
+     more than SYNC_WINDOW ahead of the other's last sync, which is at most
+     SYNC_INTERVAL old. 2048 + 1024 is under 4096, so by the time it reaches
+     done_at it has synced since the transfer was sent.*/
+    const size_t SYNC_INTERVAL = 1024;
+    const size_t SYNC_WINDOW = 2048;
+}
+
+LinkCable::LinkCable()
+{
+    m_ends[0].m_peer = &m_ends[1];
+    m_ends[1].m_peer = &m_ends[0];
+}
+
+SerialLink& LinkCable::end(size_t num)
+{
+    if (num > 1)
+    {
+        throw std::runtime_error("A link cable only has 2 ends!");
+    }
+    return m_ends[num];
+}
+
+LinkCable::End::End():
+    m_peer(nullptr),
+    m_cycles(0),
+    m_send_value(0),
+    m_send_done_at(0),
+    m_sent(0),
+    m_peer_seen(0),
+    m_reply(NO_REPLY)
+{
+}
+
+void LinkCable::End::send(uint8_t value, size_t done_at)
+{
+    m_send_value = value;
+    m_send_done_at = done_at;
+    m_sent.fetch_add(1, std::memory_order_release);
+}
+
+bool LinkCable::End::receive(size_t curr_cycles, uint8_t& value)
+{
+    //Let the peer run up to us
+    m_cycles.store(curr_cycles, std::memory_order_release);
+    
+    //Check this first, anything replied before disconnecting is then visible
+    bool gone = peer_disconnected();
+    int reply = m_reply.exchange(NO_REPLY, std::memory_order_acquire);
+    if (reply != NO_REPLY)
+    {
+        value = uint8_t(reply);
+        return true;
+    }
+    if (gone)
+    {
+        //Nothing connected
+        value = 0xff;
+        return true;
+    }
+    
+    std::this_thread::yield();
+    return false;
+}
+
+bool LinkCable::End::peer_transfer(uint8_t& value, size_t& done_at)
+{
+    uint32_t sent = m_peer->m_sent.load(std::memory_order_acquire);
+    if (sent == m_peer_seen)
+    {
+        return false;
+    }
+    
+    //The peer can't send again until we've replied to this one
+    m_peer_seen = sent;
+    value = m_peer->m_send_value;
+    done_at = m_peer->m_send_done_at;
+    return true;
+}
+
+void LinkCable::End::reply(uint8_t value)
+{
+    m_peer->m_reply.store(value, std::memory_order_release);
+}
+
+bool LinkCable::End::sync(size_t curr_cycles)
+{
+    m_cycles.store(curr_cycles, std::memory_order_release);
+    
+    if ((curr_cycles > SYNC_WINDOW) &&
+        ((curr_cycles - SYNC_WINDOW) > m_peer->m_cycles.load(std::memory_order_acquire)))
+    {
+        std::this_thread::yield();
+        return false;
+    }
+    return true;
+}
+
+size_t LinkCable::End::sync_interval() const
+{
+    return SYNC_INTERVAL;
+}
+
+void LinkCable::End::disconnect()
+{
+    m_cycles.store(DISCONNECTED, std::memory_order_release);
+}
+
+bool LinkCable::End::peer_disconnected() const
+{
+    return m_peer->m_cycles.load(std::memory_order_acquire) == DISCONNECTED;
+}
@@ -0,0 +1,65 @@
+//
+//  LinkCable.hpp
+//  GameboyEmu
+//
+//  Created by David Spickett on 18/10/2026.
+//  Copyright © 2026 David Spickett. All rights reserved.
+//
+
+#ifndef LinkCable_hpp
+#define LinkCable_hpp
+
+#include <atomic>
+#include "SerialLink.hpp"
+
+/*Connects two emulators in the same process, each running on its own
+ thread. The ends only share atomics: cycle counts published every
+ sync_interval() and the byte of a transfer in flight.*/
+class LinkCable
+{
+public:
+    LinkCable();
+    
+    //0 or 1
+    SerialLink& end(size_t num);
+    
+private:
+    class End: public SerialLink
+    {
+    public:
+        End();
+        
+        void send(uint8_t value, size_t done_at);
+        bool receive(size_t curr_cycles, uint8_t& value);
+        
+        bool peer_transfer(uint8_t& value, size_t& done_at);
+        void reply(uint8_t value);
+        
+        bool sync(size_t curr_cycles);
+        size_t sync_interval() const;
+        
+        void disconnect();
+        
+        End* m_peer;
+        
+    private:
+        bool peer_disconnected() const;
+        
+        //Published at each sync, or DISCONNECTED
+        std::atomic<size_t> m_cycles;
+        
+        //Our transfer, m_sent is bumped once the other two are written
+        uint8_t m_send_value;
+        size_t m_send_done_at;
+        std::atomic<uint32_t> m_sent;
+        //How many of the peer's transfers we've picked up
+        uint32_t m_peer_seen;
+        
+        //Peer's answer to our transfer, or NO_REPLY
+        std::atomic<int> m_reply;
+    };
+    
+    End m_ends[2];
+};
+
+#endif /* LinkCable_hpp */
@@ -84,6 +84,13 @@ public:
     
     virtual void tick(size_t curr_cycles) = 0;
     
+    //Start loading the host memory backing addr into cache, if there is any
+    virtual void prefetch(uint16_t addr) {}
+    
+    /*Host memory backing len bytes from addr, if it's plain memory that can
+     be copied from directly. Null if reads have to go through read8.*/
+    virtual const uint8_t* host_pointer(uint16_t addr, size_t len) { return nullptr; }
+    
     InterruptCallback post_int;
 };
 
@@ -98,6 +105,18 @@ class NullMemoryManager: public MemoryManager
     void tick(size_t curr_cycles) {}
 };
 
+//Stands in for memory the CPU can't get to during OAM DMA
+class DMABusManager: public MemoryManager
+{
+    using MemoryManager::MemoryManager;
+    
+    uint8_t read8(uint16_t addr) { return 0xff; }
+    void write8(uint16_t addr, uint8_t value) {}
+    uint16_t read16(uint16_t addr) { return 0xffff; };
+    void write16(uint16_t addr, uint16_t value) {}
+    void tick(size_t curr_cycles) {}
+};
+
 class DefaultMemoryManager: public MemoryManager
 {
 public:
@@ -133,6 +152,17 @@ public:
     
     void tick(size_t curr_cycles) {}
     
+    void prefetch(uint16_t addr)
+    {
+        ::prefetch(&m_mem[normalise_addr(addr)]);
+    }
+    
+    const uint8_t* host_pointer(uint16_t addr, size_t len)
+    {
+        addr = normalise_addr(addr);
+        return (addr+len) <= m_mem.size() ? &m_mem[addr] : nullptr;
+    }
+    
     void AddFile(std::string path);
     
 private:
@@ -9,6 +9,7 @@
 #include "MemoryMap.hpp"
 #include <fstream>
 #include <string>
+#include <algorithm>
 #include "utils.hpp"
 
 MemoryRange& MemoryRange::operator=(const MemoryRange& other)
@@ -60,15 +61,16 @@ void DefaultMemoryManager::AddFile(std::string path)
               m_mem.begin());
 }
 
-MemoryMap::MemoryMap(std::string& cartridge_name, bool bootstrap_skipped, int scale_factor):
+MemoryMap::MemoryMap(std::string& cartridge_name, bool bootstrap_skipped):
+    m_input_handler(),
+    m_lcd_handler(),
+    m_sound_handler(),
+    m_last_tick_cycles(0),
     m_rom_handler(cartridge_name),
-    m_lcd_handler(scale_factor),
     m_hardware_regs_handler(),
-    m_input_handler(),
     m_default_handler(),
     m_null_handler(),
-    m_sound_handler(),
-    m_last_tick_cycles(0)
+    m_dma_bus_handler()
 {
     if (!bootstrap_skipped)
     {
@@ -141,14 +143,25 @@ void MemoryMap::write8(uint16_t addr, uint8_t value)
     //Remove BIOS from ROM memory range
     if ((addr == 0xff50) && (value == 1))
     {
-        m_mem_ranges[0].manager = m_rom_handler;
+        //If DMA has the range blocked, swap what it will be restored to instead
+        bool blocked = false;
+        for (auto& b : m_dma_blocked)
+        {
+            if (b.first == 0)
+            {
+                b.second = m_rom_handler;
+                blocked = true;
+            }
+        }
+        if (!blocked)
+        {
+            m_mem_ranges[0].manager = m_rom_handler;
+        }
     }
     //Start a DMA transfer
     else if (addr == 0xff46)
     {
-        /*This potentially is wrong because we will count the cycles
-         of this instruction against the timing of the DMA.*/
-        m_dma_transfer = DMATransfer(uint16_t(value) << 8);
+        start_dma(value);
     }
     else
     {
@@ -170,6 +183,85 @@ void MemoryMap::write16(uint16_t addr, uint16_t value)
     write8(addr+1, value >> 8);
 }
 
+void MemoryMap::prefetch(uint16_t addr)
+{
+    get_mm(addr).prefetch(addr);
+}
+
+void MemoryMap::start_dma(uint8_t source_page)
+{
+    /*This potentially is wrong because we will count the cycles
+     of this instruction against the timing of the DMA.*/
+    m_dma_transfer = DMATransfer(uint16_t(source_page) << 8);
+    
+    //Starting again part way through
+    restore_dma_ranges();
+    
+    /*The CPU can't use OAM, or whichever bus DMA is reading from. VRAM has
+     its own bus, everything else outside the CPU is on the external bus.
+     Swapping the ranges means reads and writes don't have to check for DMA.*/
+    uint16_t source = m_dma_transfer.source_addr;
+    bool from_vram = (source >= LCD_MEM_START) && (source < LCD_MEM_END);
+    for (size_t i=0; i<m_mem_ranges.size(); ++i)
+    {
+        MemoryRange& range = m_mem_ranges[i];
+        bool vram_bus = (range.start >= LCD_MEM_START) && (range.start < LCD_MEM_END);
+        bool external_bus = (range.start < LCD_MEM_START) ||
+            ((range.start >= CART_RAM_START) && (range.start < LCD_OAM_START));
+        
+        if ((range.start == LCD_OAM_START) || (from_vram ? vram_bus : external_bus))
+        {
+            m_dma_blocked.push_back(std::make_pair(i, range.manager));
+            range.manager = m_dma_bus_handler;
+        }
+    }
+}
+
+void MemoryMap::restore_dma_ranges()
+{
+    for (auto& blocked : m_dma_blocked)
+    {
+        m_mem_ranges[blocked.first].manager = blocked.second;
+    }
+    m_dma_blocked.clear();
+}
+
+void MemoryMap::finish_dma()
+{
+    restore_dma_ranges();
+    
+    //Most sources are plain memory that can be copied in one go
+    uint16_t source = m_dma_transfer.source_addr;
+    MemoryManager& source_m = get_mm(source);
+    const uint8_t* data = source_m.host_pointer(source, LCD_OAM_SIZE);
+    if (data)
+    {
+        m_lcd_handler.oam_dma(data);
+    }
+    else
+    {
+        OAMData copy;
+        for (uint16_t i=0; i<LCD_OAM_SIZE; ++i)
+        {
+            copy[i] = source_m.read8(source+i);
+        }
+        m_lcd_handler.oam_dma(copy.data());
+    }
+}
+
+size_t MemoryMap::cycles_to_next_event() const
+{
+    size_t next = std::min(m_lcd_handler.next_event_cycles(),
+                           m_hardware_regs_handler.next_event_cycles());
+    //Already due if it's at or before the last tick
+    next = next > m_last_tick_cycles ? next - m_last_tick_cycles : 0;
+    if (m_dma_transfer.cycles_remaining > 0)
+    {
+        next = std::min(next, size_t(m_dma_transfer.cycles_remaining));
+    }
+    return next;
+}
+
 void MemoryMap::tick(size_t curr_cycles)
 {
     if (m_dma_transfer.cycles_remaining > 0)
@@ -179,19 +271,14 @@ void MemoryMap::tick(size_t curr_cycles)
         if (m_dma_transfer.cycles_remaining <= 0)
         {
             m_dma_transfer.cycles_remaining = -1;
-            
-            MemoryManager& source_m = get_mm(m_dma_transfer.source_addr);
-            uint16_t read_addr = m_dma_transfer.source_addr;
-            for (uint16_t write_addr=LCD_OAM_START; write_addr<LCD_OAM_END; ++read_addr,++write_addr)
-            {
-                m_lcd_handler.write8(write_addr, source_m.read8(read_addr));
-            }
+            finish_dma();
         }
     }
     
     m_input_handler.tick(curr_cycles);
     m_lcd_handler.tick(curr_cycles);
     m_hardware_regs_handler.tick(curr_cycles);
+    m_sound_handler.tick(curr_cycles);
     
     m_last_tick_cycles = curr_cycles;
 }
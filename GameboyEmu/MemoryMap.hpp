@@ -40,7 +40,7 @@ using MemoryRanges = std::vector<MemoryRange>;
 class MemoryMap
 {
 public:
-    MemoryMap(std::string& cartridge_name, bool bootstrap_skipped, int scale_factor);
+    MemoryMap(std::string& cartridge_name, bool bootstrap_skipped);
     
     uint8_t read8(uint16_t addr);
     void write8(uint16_t addr, uint8_t value);
@@ -49,10 +49,29 @@ public:
     void write16(uint16_t addr, uint16_t value);
     
     void tick(size_t curr_cycles);
+    /*Clocks until something could next raise an interrupt or change the
+     LCD's mode. Nothing happens between now and then, so ticking once at
+     that point is the same as ticking many times on the way.*/
+    size_t cycles_to_next_event() const;
+    
+    //Warm the cache for an address that is about to be used
+    void prefetch(uint16_t addr);
+    
+    //Plug a link cable into the serial port
+    void connect_serial(SerialLink* link) { m_hardware_regs_handler.connect(link); }
+    SerialOutput& serial_output() { return m_hardware_regs_handler.serial_output(); }
+    
+    //Cartridge header details, for printing
+    std::string rom_info() { return m_rom_handler.get_info(); }
+    
+    int rom_bank() const { return m_rom_handler.current_rom_bank(); }
+    size_t num_rom_banks() const { return m_rom_handler.num_rom_banks(); }
     
     InputManager m_input_handler;
     
-    LCD m_lcd_handler; //public for screenshots
+    LCD m_lcd_handler; //public for frames
+    
+    SoundHandler m_sound_handler; //public for frame pacing
     
     void set_int_callback(InterruptCallback callback)
     {
@@ -87,6 +106,13 @@ private:
         uint16_t source_addr;
     } m_dma_transfer;
     
+    /*While OAM DMA runs, OAM and the bus it's copying from are swapped for
+     m_dma_bus_handler. These are the ranges swapped and what they were.*/
+    void start_dma(uint8_t source_page);
+    void finish_dma();
+    void restore_dma_ranges();
+    std::vector<std::pair<size_t, std::reference_wrapper<MemoryManager>>> m_dma_blocked;
+    
     size_t m_last_tick_cycles;
     MemoryRanges m_mem_ranges;
     
@@ -95,7 +121,7 @@ private:
     HardwareIORegs m_hardware_regs_handler;
     DefaultMemoryManager m_default_handler;
     NullMemoryManager m_null_handler;
-    SoundHandler m_sound_handler;
+    DMABusManager m_dma_bus_handler;
     
 };
 
@@ -0,0 +1,230 @@
+//
+//  Profiler.cpp
+//  GameboyEmu
+//
+//  Created by David Spickett on 18/10/2026.
+//  Copyright © 2026 David Spickett. All rights reserved.
+//
+
+#include "Profiler.hpp"
+#include <fstream>
+#include <sstream>
+#include <map>
+#include <algorithm>
+#include <stdexcept>
+#include "utils.hpp"
+
+Profiler::Profiler(size_t num_rom_banks):
+    m_num_rom_banks(std::max(num_rom_banks, size_t(2)))
+{
+    //ROM banks, 0x8000-0xffff then the unknown bank
+    size_t num_buckets = (m_num_rom_banks+3) * 0x4000;
+    m_cycles = std::vector<uint64_t>(num_buckets, 0);
+    m_instructions = std::vector<uint64_t>(num_buckets, 0);
+}
+
+Profiler::Location Profiler::location(size_t bucket) const
+{
+    Location loc;
+    if (bucket < 0x4000)
+    {
+        loc.bank = 0;
+        loc.addr = bucket;
+    }
+    else if (bucket < (m_num_rom_banks * 0x4000))
+    {
+        loc.bank = int(bucket / 0x4000);
+        loc.addr = 0x4000 + (bucket % 0x4000);
+    }
+    else if (bucket < ((m_num_rom_banks+2) * 0x4000))
+    {
+        loc.bank = RAM_BANK;
+        loc.addr = 0x8000 + (bucket - (m_num_rom_banks * 0x4000));
+    }
+    else
+    {
+        loc.bank = UNKNOWN_BANK;
+        loc.addr = 0x4000 + (bucket % 0x4000);
+    }
+    return loc;
+}
+
+size_t Profiler::region(size_t bucket) const
+{
+    //RAM is one region even though it's 2 banks long
+    size_t bank = bucket / 0x4000;
+    return (bank == (m_num_rom_banks+1)) ? m_num_rom_banks : bank;
+}
+
+std::string Profiler::region_str(size_t bucket) const
+{
+    Location loc = location(bucket);
+    switch (loc.bank)
+    {
+        case RAM_BANK:
+            return "RAM";
+        case UNKNOWN_BANK:
+            return "ROM??";
+        default:
+            return formatted_string("ROM%02x", loc.bank);
+    }
+}
+
+std::string Profiler::location_str(size_t bucket) const
+{
+    Location loc = location(bucket);
+    switch (loc.bank)
+    {
+        case RAM_BANK:
+            return formatted_string("00:%04x", loc.addr);
+        case UNKNOWN_BANK:
+            return formatted_string("??:%04x", loc.addr);
+        default:
+            return formatted_string("%02x:%04x", loc.bank, loc.addr);
+    }
+}
+
+void Profiler::LoadSymbols(const std::string& path)
+{
+    std::ifstream in(path.c_str());
+    if (!in.is_open())
+    {
+        throw std::runtime_error(formatted_string("File %s does not exist.", path.c_str()));
+    }
+    
+    std::string line;
+    while (std::getline(in, line))
+    {
+        line = line.substr(0, line.find(';'));
+        
+        unsigned bank = 0, addr = 0;
+        char name[256];
+        if (sscanf(line.c_str(), "%x:%x %255s", &bank, &addr, name) == 3)
+        {
+            //Not in this ROM, it would only name whatever ends up in the unknown bank
+            if ((addr >= 0x4000) && (addr < 0x8000) && (bank >= m_num_rom_banks))
+            {
+                continue;
+            }
+            
+            Symbol s;
+            s.bucket = bucket(uint16_t(addr), int(bank));
+            s.name = name;
+            m_symbols.push_back(s);
+        }
+    }
+    
+    std::stable_sort(m_symbols.begin(), m_symbols.end());
+}
+
+const Profiler::Symbol* Profiler::find_symbol(size_t bucket) const
+{
+    Symbol key;
+    key.bucket = bucket;
+    auto it = std::upper_bound(m_symbols.begin(), m_symbols.end(), key);
+    if (it == m_symbols.begin())
+    {
+        return nullptr;
+    }
+    --it;
+    
+    //Don't let a routine at the end of one bank claim the start of the next
+    if (region(it->bucket) != region(bucket))
+    {
+        return nullptr;
+    }
+    return &(*it);
+}
+
+void Profiler::WriteReport(const std::string& path, size_t max_entries) const
+{
+    struct Entry
+    {
+        std::string name;
+        uint64_t cycles;
+        uint64_t instructions;
+    };
+    
+    //Totals per routine, or per address when there's no symbol
+    std::map<std::string, Entry> entries;
+    uint64_t total_cycles = 0;
+    for (size_t i=0; i<m_cycles.size(); ++i)
+    {
+        if (!m_instructions[i])
+        {
+            continue;
+        }
+        total_cycles += m_cycles[i];
+        
+        const Symbol* sym = find_symbol(i);
+        std::string key = sym ? location_str(sym->bucket) : location_str(i);
+        
+        auto found = entries.find(key);
+        if (found == entries.end())
+        {
+            Entry e = {sym ? sym->name : "", 0, 0};
+            found = entries.insert(std::make_pair(key, e)).first;
+        }
+        found->second.cycles += m_cycles[i];
+        found->second.instructions += m_instructions[i];
+    }
+    
+    std::vector<std::pair<std::string, Entry>> sorted(entries.begin(), entries.end());
+    std::sort(sorted.begin(), sorted.end(),
+              [](const std::pair<std::string, Entry>& lhs, const std::pair<std::string, Entry>& rhs)
+              { return lhs.second.cycles > rhs.second.cycles; });
+    
+    std::ofstream out(path.c_str());
+    if (!out.is_open())
+    {
+        throw std::runtime_error(formatted_string("Could not open %s for writing.", path.c_str()));
+    }
+    
+    out << formatted_string("Total cycles: %llu\n\n", (unsigned long long)total_cycles);
+    out << formatted_string("%14s %7s %12s %-8s %s\n", "Cycles", "%", "Instrs", "Location", "Routine");
+    
+    size_t count = 0;
+    for (auto& e : sorted)
+    {
+        if (count++ == max_entries)
+        {
+            break;
+        }
+        double percent = total_cycles ? (100.0 * e.second.cycles) / total_cycles : 0;
+        out << formatted_string("%14llu %6.2f%% %12llu %-8s %s\n",
+                                (unsigned long long)e.second.cycles, percent,
+                                (unsigned long long)e.second.instructions,
+                                e.first.c_str(), e.second.name.c_str());
+    }
+}
+
+void Profiler::WriteCollapsed(const std::string& path) const
+{
+    std::ofstream out(path.c_str());
+    if (!out.is_open())
+    {
+        throw std::runtime_error(formatted_string("Could not open %s for writing.", path.c_str()));
+    }
+    
+    for (size_t i=0; i<m_cycles.size(); ++i)
+    {
+        if (!m_cycles[i])
+        {
+            continue;
+        }
+        
+        std::string frames = region_str(i);
+        const Symbol* sym = find_symbol(i);
+        if (sym)
+        {
+            frames += formatted_string(";%s;%s+0x%x", sym->name.c_str(), sym->name.c_str(),
+                                       unsigned(i - sym->bucket));
+        }
+        else
+        {
+            frames += ";" + location_str(i);
+        }
+        
+        out << frames << " " << m_cycles[i] << "\n";
+    }
+}
@@ -0,0 +1,96 @@
+//
+//  Profiler.hpp
+//  GameboyEmu
+//
+//  Created by David Spickett on 18/10/2026.
+//  Copyright © 2026 David Spickett. All rights reserved.
+//
+
+#ifndef Profiler_hpp
+#define Profiler_hpp
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+//Set to 0 to compile the guest profiler out of Step() entirely
+#ifndef GUEST_PROFILER
+#define GUEST_PROFILER 1
+#endif
+
+/*Counts the cycles spent at each guest PC. ROM addresses are kept apart by
+ bank so that code in different switchable banks isn't merged. Buckets are
+ one flat array allocated up front, so recording is just an add.
+ 
+ The array is the ROM banks, then 0x8000-0xffff, then one more bank for
+ 0x4000-0x7fff when the selected bank isn't in the ROM.*/
+class Profiler
+{
+public:
+    explicit Profiler(size_t num_rom_banks);
+    
+    void record(uint16_t pc, int rom_bank, uint32_t cycles)
+    {
+        size_t index = bucket(pc, rom_bank);
+        m_cycles[index] += cycles;
+        m_instructions[index]++;
+    }
+    
+    //RGBDS .sym file, lines of "bank:addr name"
+    void LoadSymbols(const std::string& path);
+    
+    //Hottest routines (or addresses if there are no symbols) first
+    void WriteReport(const std::string& path, size_t max_entries=100) const;
+    //One line per address, "bank;routine;routine+offset cycles"
+    void WriteCollapsed(const std::string& path) const;
+    
+private:
+    size_t bucket(uint16_t addr, int rom_bank) const
+    {
+        if (addr < 0x4000)
+        {
+            return addr;
+        }
+        else if (addr < 0x8000)
+        {
+            //Not a real bank, don't let it count towards one that is
+            if ((rom_bank < 0) || (size_t(rom_bank) >= m_num_rom_banks))
+            {
+                return ((m_num_rom_banks+2) * 0x4000) + (addr - 0x4000);
+            }
+            return (size_t(rom_bank) * 0x4000) + (addr - 0x4000);
+        }
+        //Anything running from RAM goes after the ROM banks
+        return (m_num_rom_banks * 0x4000) + (addr - 0x8000);
+    }
+    
+    struct Symbol
+    {
+        size_t bucket;
+        std::string name;
+        
+        bool operator<(const Symbol& rhs) const { return bucket < rhs.bucket; }
+    };
+    
+    struct Location
+    {
+        int bank; //RAM_BANK or UNKNOWN_BANK if not a ROM bank
+        uint16_t addr;
+    };
+    static const int RAM_BANK = -1;
+    static const int UNKNOWN_BANK = -2;
+    
+    Location location(size_t bucket) const;
+    std::string location_str(size_t bucket) const;
+    std::string region_str(size_t bucket) const;
+    size_t region(size_t bucket) const;
+    //Symbol at or before the bucket, in the same bank. nullptr if none.
+    const Symbol* find_symbol(size_t bucket) const;
+    
+    size_t m_num_rom_banks;
+    std::vector<uint64_t> m_cycles;
+    std::vector<uint64_t> m_instructions;
+    std::vector<Symbol> m_symbols;
+};
+
+#endif /* Profiler_hpp */
@@ -0,0 +1,87 @@
+//
+//  RingBuffer.hpp
+//  GameboyEmu
+//
+//  Created by David Spickett on 18/10/2026.
+//  Copyright © 2026 David Spickett. All rights reserved.
+//
+
+#ifndef RingBuffer_hpp
+#define RingBuffer_hpp
+
+#include <stdint.h>
+#include <atomic>
+#include <vector>
+#include <algorithm>
+
+/*Lock free queue for exactly one producer thread and one consumer thread.
+ The indexes only ever increase, so full and empty can be told apart without
+ wasting a slot.*/
+template <class T> class RingBuffer
+{
+public:
+    //Capacity is rounded up to a power of 2
+    explicit RingBuffer(size_t capacity):
+        m_write(0),
+        m_read(0)
+    {
+        size_t size = 1;
+        while (size < capacity)
+        {
+            size <<= 1;
+        }
+        m_data = std::vector<T>(size, T());
+        m_mask = size-1;
+    }
+    
+    //Producer side, returns how many were added. Anything that doesn't fit is dropped.
+    size_t push(const T* data, size_t count)
+    {
+        size_t write = m_write.load(std::memory_order_relaxed);
+        size_t read = m_read.load(std::memory_order_acquire);
+        count = std::min(count, m_data.size()-(write-read));
+        
+        for (size_t i=0; i<count; ++i)
+        {
+            m_data[(write+i) & m_mask] = data[i];
+        }
+        
+        m_write.store(write+count, std::memory_order_release);
+        return count;
+    }
+    
+    //Consumer side, returns how many were removed
+    size_t pop(T* data, size_t count)
+    {
+        size_t read = m_read.load(std::memory_order_relaxed);
+        size_t write = m_write.load(std::memory_order_acquire);
+        count = std::min(count, write-read);
+        
+        for (size_t i=0; i<count; ++i)
+        {
+            data[i] = m_data[(read+i) & m_mask];
+        }
+        
+        m_read.store(read+count, std::memory_order_release);
+        return count;
+    }
+    
+    //Approximate when called from the producer or consumer while the other is running
+    size_t size() const
+    {
+        return m_write.load(std::memory_order_acquire) - m_read.load(std::memory_order_acquire);
+    }
+    
+    size_t capacity() const { return m_data.size(); }
+    
+private:
+    std::vector<T> m_data;
+    size_t m_mask;
+    
+    //Keep the two indexes on different cache lines so the threads don't fight over them
+    std::atomic<size_t> m_write;
+    char m_padding[64];
+    std::atomic<size_t> m_read;
+};
+
+#endif /* RingBuffer_hpp */
@@ -35,7 +35,6 @@ ROMHandler::ROMHandler(std::string file_path):
     
     m_rom_contents = std::vector<uint8_t>(std::istreambuf_iterator<char>(file_str), std::istreambuf_iterator<char>());
     
-    printf("%s\n", get_info().c_str());
     if (is_cgb_only())
     {
         throw std::runtime_error("ROM is CGB only.");
@@ -370,16 +369,57 @@ std::string ROMHandler::get_info()
         );
 }
 
+int ROMHandler::current_rom_bank() const
+{
+    int rom_bank = m_rom_bank_no;
+    if (m_rom_ram_mode == ROM_MODE)
+    {
+        //RAM bank number used as the upper bits of ROM bank number (which is 5 bits)
+        rom_bank += (m_ram_bank_no << 5);
+    }
+    return rom_bank;
+}
+
+void ROMHandler::prefetch(uint16_t addr)
+{
+    size_t offset = addr;
+    if ((addr >= SWITCHABLE_ROM_START) && (addr < SWITCHABLE_ROM_END))
+    {
+        offset += 16*1024*(current_rom_bank()-1);
+    }
+    else if (addr >= SWITCHABLE_ROM_END)
+    {
+        //Cart RAM is small enough that it'll be in cache if it's being used
+        return;
+    }
+    
+    if (offset < m_rom_contents.size())
+    {
+        ::prefetch(m_rom_contents.data()+offset);
+    }
+}
+
+const uint8_t* ROMHandler::host_pointer(uint16_t addr, size_t len)
+{
+    if ((addr >= CART_RAM_START) && (addr < CART_RAM_END))
+    {
+        size_t offset = addr-CART_RAM_START;
+        return (offset+len) <= m_ram_bank.size() ? m_ram_bank.data()+offset : nullptr;
+    }
+    
+    size_t offset = addr;
+    if ((addr >= SWITCHABLE_ROM_START) && (addr < SWITCHABLE_ROM_END))
+    {
+        offset += 16*1024*(current_rom_bank()-1);
+    }
+    return (offset+len) <= m_rom_contents.size() ? m_rom_contents.data()+offset : nullptr;
+}
+
 uint8_t ROMHandler::read8(uint16_t addr)
 {
     if ((addr >= SWITCHABLE_ROM_START) && (addr < SWITCHABLE_ROM_END))
     {
-        int rom_bank = m_rom_bank_no;
-        if (m_rom_ram_mode == ROM_MODE)
-        {
-            //RAM bank number used as the upper bits of ROM bank number (which is 5 bits)
-            rom_bank += (m_ram_bank_no << 5);
-        }
+        int rom_bank = current_rom_bank();
         
         //-1 because switchable banks are 1 indexed, bank 0 is always mapped in the 16k before switchable
         size_t offset = 16*1024*(rom_bank-1);
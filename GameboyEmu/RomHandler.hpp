@@ -27,7 +27,13 @@ public:
     bool is_cgb_only();
     std::string get_info();
     
+    //Bank currently mapped at 0x4000-0x7fff
+    int current_rom_bank() const;
+    size_t num_rom_banks() const { return m_rom_contents.size() / 0x4000; }
+    
     void tick(size_t curr_cycles) {}
+    void prefetch(uint16_t addr);
+    const uint8_t* host_pointer(uint16_t addr, size_t len);
     
 private:
     std::vector<uint8_t> m_rom_contents;
@@ -7,12 +7,16 @@
 //
 
 #include "SDLApp.hpp"
+#include <stdexcept>
 
-void SDLApp::SaveImage(std::string filename)
+void SDLApp::SaveImage(std::string filename, const LCDFrame& frame)
 {
-    SDL_Surface *temp_sur = SDL_CreateRGBSurface(0, m_sdl_width, m_sdl_height, 32, 0x00ff0000, 0x0000ff00, 0x000000ff, 0xff000000);
-    SDL_RenderReadPixels(m_renderer, NULL, SDL_PIXELFORMAT_ARGB8888,
-                         temp_sur->pixels, temp_sur->pitch);
+    m_expander.expand(frame, m_pixels.data(), LCD_WIDTH*sizeof(uint32_t));
+    
+    //The surface only points to the pixels, it doesn't copy them
+    SDL_Surface *temp_sur = SDL_CreateRGBSurfaceFrom(
+        m_pixels.data(), LCD_WIDTH, LCD_HEIGHT, 32, LCD_WIDTH*sizeof(uint32_t),
+        0x00ff0000, 0x0000ff00, 0x000000ff, 0xff000000);
     
     SDL_SaveBMP(temp_sur, filename.c_str());
     SDL_FreeSurface(temp_sur);
@@ -20,7 +24,7 @@ void SDLApp::SaveImage(std::string filename)
 
 void SDLApp::Clear()
 {
-    //Clear whole screen when LCD is disabled.
+    //White until the first frame arrives
     SDL_SetRenderDrawColor(m_renderer, 255, 255, 255, 255);
     
     SDL_Rect r;
@@ -33,31 +37,26 @@ void SDLApp::Clear()
     SDL_RenderPresent(m_renderer);
 }
 
-void SDLApp::Draw(uint8_t curr_scanline)
+void SDLApp::Present(const LCDFrame& frame)
 {
-    SDL_Rect r;
-    r.h = m_scale_factor;
-    r.w = m_scale_factor;
-    r.x = 0;
-    r.y = curr_scanline*m_scale_factor;
-    
-    auto p_start(m_pixel_data.cbegin()+(curr_scanline*LCD_WIDTH));
-    auto p_end(p_start+LCD_WIDTH);
-    for ( ; p_start != p_end; ++p_start, r.x+=m_scale_factor)
+    void* pixels;
+    int pitch;
+    if (SDL_LockTexture(m_texture, NULL, &pixels, &pitch) == 0)
     {
-        SDL_SetRenderDrawColor(m_renderer, p_start->r, p_start->g, p_start->b, p_start->a);
-        SDL_RenderFillRect(m_renderer, &r);
-    }
-    
-    //Draw
-    //SDL_RenderPresent(m_renderer);
-    static auto delay = 0;
-    if (delay == 200)
-    {
-        SDL_RenderPresent(m_renderer);
-        delay = 0;
+        if (m_scale_factor == 1)
+        {
+            //Nothing to scale so expand straight into the texture
+            m_expander.expand(frame, static_cast<uint32_t*>(pixels), pitch);
+        }
+        else
+        {
+            m_expander.expand(frame, m_pixels.data(), LCD_WIDTH*sizeof(uint32_t));
+            m_upscaler.scale(m_pixels.data(), static_cast<uint32_t*>(pixels), pitch);
+        }
+        SDL_UnlockTexture(m_texture);
     }
-    delay++;
+    SDL_RenderCopy(m_renderer, m_texture, NULL, NULL);
+    SDL_RenderPresent(m_renderer);
 }
 
 void SDLApp::Init()
@@ -85,6 +84,13 @@ void SDLApp::Init()
         }
         
         m_renderer = SDL_CreateRenderer(m_window, -1, SDL_RENDERER_ACCELERATED);
+        m_texture = SDL_CreateTexture(m_renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING,
+                                      m_sdl_width, m_sdl_height);
+        if (m_texture == NULL)
+        {
+            throw std::runtime_error(formatted_string(
+              "Texture could not be created! SDL_Error: %s\n", SDL_GetError()));
+        }
         
         Clear();
     }
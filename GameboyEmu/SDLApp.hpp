@@ -13,53 +13,51 @@
 #include <string>
 #include <array>
 #include "utils.hpp"
+#include "LCDFrame.hpp"
+#include "Upscaler.hpp"
+#include <vector>
 
-const size_t LCD_WIDTH      = 160;
-const size_t LCD_HEIGHT     = 144;
-
-struct colour
-{
-    colour(uint8_t r, uint8_t g, uint8_t b):
-    a(SDL_ALPHA_OPAQUE), r(r), g(g), b(b)
-    {}
-    
-    colour():
-    a(SDL_ALPHA_OPAQUE), r(255), g(255), b(255)
-    {}
-    
-    uint8_t r, g, b, a;
-};
-
+//Owned by the main thread, the emulator core never calls SDL
 class SDLApp
 {
 public:
-    explicit SDLApp(int scale_factor):
+    SDLApp(int scale_factor, ScaleFilter filter):
+        m_renderer(NULL),
+        m_window(NULL),
+        m_texture(NULL),
+        m_expander(default_shades()),
+        m_upscaler(filter, scale_factor),
+        m_pixels(LCD_WIDTH*LCD_HEIGHT),
         m_scale_factor(scale_factor),
         m_sdl_width(LCD_WIDTH*scale_factor),
         m_sdl_height(LCD_HEIGHT*scale_factor)
-    {
-        init_array(m_pixel_data);
-    }
+    {}
     
     ~SDLApp()
     {
         if (m_window != NULL)
         {
+            SDL_DestroyTexture(m_texture);
             SDL_DestroyRenderer(m_renderer);
             SDL_DestroyWindow(m_window);
             SDL_Quit();
         }
     }
-    void SaveImage(std::string filename);
+    //Saved at the LCD's size, not the window's
+    void SaveImage(std::string filename, const LCDFrame& frame);
     void Init();
-    void Draw(uint8_t curr_scanline);
+    void Present(const LCDFrame& frame);
     void Clear();
     
-    std::array<colour, LCD_HEIGHT*LCD_WIDTH> m_pixel_data;
-    
 private:
     SDL_Renderer* m_renderer;
     SDL_Window* m_window;
+    //The size of the window, frames are scaled on the CPU
+    SDL_Texture* m_texture;
+    FrameExpander m_expander;
+    Upscaler m_upscaler;
+    //The frame before scaling
+    std::vector<uint32_t> m_pixels;
     
     int m_scale_factor;
     int m_sdl_height;
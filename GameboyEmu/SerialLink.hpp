@@ -0,0 +1,48 @@
+//
+//  SerialLink.hpp
+//  GameboyEmu
+//
+//  Created by David Spickett on 18/10/2026.
+//  Copyright © 2026 David Spickett. All rights reserved.
+//
+
+#ifndef SerialLink_hpp
+#define SerialLink_hpp
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*One end of a link cable. Bytes are swapped whole when a transfer finishes
+ instead of being shifted a bit at a time.
+ 
+ The end using the internal clock announces its transfer with send, then
+ collects the other end's byte with receive once its cycle count reaches
+ done_at. The other end finds the transfer with peer_transfer and answers
+ it with reply when its own cycle count reaches done_at.
+ 
+ sync must be called at least every sync_interval() clocks. It stops one
+ end getting too far ahead of the other, which for a window shorter than
+ a transfer means both ends see each transfer at the same emulated time.
+ 
+ sync and receive wait a while then return false if they need calling
+ again. In between, check peer_transfer, the other end may be waiting for
+ an answer before it can do what we're waiting for.*/
+class SerialLink
+{
+public:
+    virtual ~SerialLink() {}
+    
+    virtual void send(uint8_t value, size_t done_at) = 0;
+    virtual bool receive(size_t curr_cycles, uint8_t& value) = 0;
+    
+    virtual bool peer_transfer(uint8_t& value, size_t& done_at) = 0;
+    virtual void reply(uint8_t value) = 0;
+    
+    virtual bool sync(size_t curr_cycles) = 0;
+    virtual size_t sync_interval() const = 0;
+    
+    //This end has stopped running, don't let the other end wait for it
+    virtual void disconnect() = 0;
+};
+
+#endif /* SerialLink_hpp */
@@ -0,0 +1,51 @@
+//
+//  SerialOutput.cpp
+//  GameboyEmu
+//
+//  Created by David Spickett on 18/10/2026.
+//  Copyright © 2026 David Spickett. All rights reserved.
+//
+
+#include "SerialOutput.hpp"
+
+namespace
+{
+    const size_t MAX_TEXT = 64*1024;
+    
+    bool ends_with(const std::string& text, const std::string& end)
+    {
+        return (text.size() >= end.size()) &&
+            (text.compare(text.size()-end.size(), end.size(), end) == 0);
+    }
+}
+
+void SerialOutput::write(uint8_t value)
+{
+    if (m_text.size() == MAX_TEXT)
+    {
+        size_t dropped = MAX_TEXT/2;
+        m_text.erase(0, dropped);
+        m_printed = m_printed > dropped ? m_printed-dropped : 0;
+    }
+    m_text.push_back(char(value));
+    
+    //Both end in 'd', so most bytes are done with here
+    if ((m_result == TEST_NONE) && (value == 'd'))
+    {
+        if (ends_with(m_text, "Passed"))
+        {
+            m_result = TEST_PASSED;
+        }
+        else if (ends_with(m_text, "Failed"))
+        {
+            m_result = TEST_FAILED;
+        }
+    }
+}
+
+std::string SerialOutput::take_unprinted()
+{
+    std::string text = m_text.substr(m_printed);
+    m_printed = m_text.size();
+    return text;
+}
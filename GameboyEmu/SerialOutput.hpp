@@ -0,0 +1,44 @@
+//
+//  SerialOutput.hpp
+//  GameboyEmu
+//
+//  Created by David Spickett on 18/10/2026.
+//  Copyright © 2026 David Spickett. All rights reserved.
+//
+
+#ifndef SerialOutput_hpp
+#define SerialOutput_hpp
+
+#include <stdint.h>
+#include <string>
+
+enum TestResult { TEST_NONE, TEST_PASSED, TEST_FAILED };
+
+/*Bytes written to SB, which test ROMs use to print their results. They're
+ kept per instance instead of being printed as they come, so that many
+ instances can run at once without mixing their output or waiting on stdout.*/
+class SerialOutput
+{
+public:
+    SerialOutput():
+        m_result(TEST_NONE),
+        m_printed(0)
+    {}
+    
+    void write(uint8_t value);
+    
+    const std::string& text() const { return m_text; }
+    //From the first "Passed" or "Failed" written
+    TestResult result() const { return m_result; }
+    
+    //Text written since the last call
+    std::string take_unprinted();
+    
+private:
+    //Only the newest text is kept, games using the link cable write to SB forever
+    std::string m_text;
+    TestResult m_result;
+    size_t m_printed;
+};
+
+#endif /* SerialOutput_hpp */
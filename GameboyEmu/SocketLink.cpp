@@ -0,0 +1,373 @@
+//
+//  SocketLink.cpp
+//  GameboyEmu
+//
+//  Created by David Spickett on 18/10/2026.
+//  Copyright © 2026 David Spickett. All rights reserved.
+//
+
+#include "SocketLink.hpp"
+#include <algorithm>
+#include <stdexcept>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "utils.hpp"
+
+namespace
+{
+    //Type, value then 8 byte little endian cycle count
+    const size_t MESSAGE_SIZE = 10;
+    //How long receive and sync wait before letting the caller check for transfers
+    const int WAIT_MS = 1;
+    //About 1ms at full speed
+    const size_t MAX_SYNC_INTERVAL = 4096;
+    
+    bool is_port(const std::string& address)
+    {
+        return !address.empty() &&
+            std::all_of(address.begin(), address.end(), [](char c) { return (c >= '0') && (c <= '9'); });
+    }
+    
+    std::string socket_error(const char* what, const std::string& address)
+    {
+        return formatted_string("Link cable %s on %s failed: %s", what, address.c_str(), strerror(errno));
+    }
+    
+    //Returns the socket and fills in the address to bind or connect to
+    int make_socket(const std::string& address, sockaddr_storage& addr, socklen_t& addr_len)
+    {
+        memset(&addr, 0, sizeof(addr));
+        int fd = -1;
+        
+        if (is_port(address))
+        {
+            //Anything longer can't be in range and might not fit in a long
+            unsigned long port = (address.size() <= 5) ? std::stoul(address) : 0;
+            if ((port < 1) || (port > 65535))
+            {
+                throw std::runtime_error(formatted_string("Link cable port %s is not between 1 and 65535.", address.c_str()));
+            }
+            sockaddr_in* in = reinterpret_cast<sockaddr_in*>(&addr);
+            in->sin_family = AF_INET;
+            in->sin_port = htons(uint16_t(port));
+            in->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            addr_len = sizeof(sockaddr_in);
+            fd = socket(AF_INET, SOCK_STREAM, 0);
+        }
+        else
+        {
+            sockaddr_un* un = reinterpret_cast<sockaddr_un*>(&addr);
+            if (address.size() >= sizeof(un->sun_path))
+            {
+                throw std::runtime_error(formatted_string("Link cable socket path %s is too long.", address.c_str()));
+            }
+            un->sun_family = AF_UNIX;
+            strncpy(un->sun_path, address.c_str(), sizeof(un->sun_path)-1);
+            addr_len = sizeof(sockaddr_un);
+            fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        }
+        
+        if (fd < 0)
+        {
+            throw std::runtime_error(socket_error("socket", address));
+        }
+        return fd;
+    }
+    
+    //Messages are tiny and each one is waited on, don't hold them back
+    void set_options(int fd, const std::string& address)
+    {
+        if (is_port(address))
+        {
+            int on = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+        }
+#ifdef SO_NOSIGPIPE
+        int on = 1;
+        setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    }
+}
+
+std::unique_ptr<SocketLink> SocketLink::listen_on(const std::string& address, size_t window)
+{
+    sockaddr_storage addr;
+    socklen_t addr_len = 0;
+    int listener = make_socket(address, addr, addr_len);
+    
+    if (is_port(address))
+    {
+        int on = 1;
+        setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    }
+    else
+    {
+        //Left over from a previous run
+        unlink(address.c_str());
+    }
+    
+    if ((bind(listener, reinterpret_cast<sockaddr*>(&addr), addr_len) != 0) ||
+        (::listen(listener, 1) != 0))
+    {
+        std::string err = socket_error("listen", address);
+        close(listener);
+        throw std::runtime_error(err);
+    }
+    
+    printf("Waiting for the other end of the link cable on %s\n", address.c_str());
+    int fd = accept(listener, nullptr, nullptr);
+    std::string err = socket_error("accept", address);
+    close(listener);
+    if (!is_port(address))
+    {
+        unlink(address.c_str());
+    }
+    if (fd < 0)
+    {
+        throw std::runtime_error(err);
+    }
+    
+    set_options(fd, address);
+    return std::unique_ptr<SocketLink>(new SocketLink(fd, window));
+}
+
+std::unique_ptr<SocketLink> SocketLink::connect_to(const std::string& address, size_t window)
+{
+    sockaddr_storage addr;
+    socklen_t addr_len = 0;
+    int fd = make_socket(address, addr, addr_len);
+    
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), addr_len) != 0)
+    {
+        std::string err = socket_error("connect", address);
+        close(fd);
+        throw std::runtime_error(err);
+    }
+    
+    set_options(fd, address);
+    return std::unique_ptr<SocketLink>(new SocketLink(fd, window));
+}
+
+SocketLink::SocketLink(int fd, size_t window):
+    m_fd(fd),
+    m_window(std::max(window, size_t(2))),
+    m_peer_cycles(0),
+    m_published_cycles(0),
+    m_have_peer_transfer(false),
+    m_peer_value(0),
+    m_peer_done_at(0),
+    m_have_reply(false),
+    m_reply(0)
+{
+}
+
+SocketLink::~SocketLink()
+{
+    disconnect();
+}
+
+void SocketLink::send(uint8_t value, size_t done_at)
+{
+    write_message(MSG_SEND, value, done_at);
+}
+
+bool SocketLink::receive(size_t curr_cycles, uint8_t& value)
+{
+    if (!m_have_reply && (m_fd >= 0))
+    {
+        //The other end may be held up waiting for us to get this far
+        publish_cycles(curr_cycles);
+        read_messages(WAIT_MS);
+    }
+    
+    if (m_have_reply)
+    {
+        m_have_reply = false;
+        value = m_reply;
+        return true;
+    }
+    if (m_fd < 0)
+    {
+        //Nothing connected
+        value = 0xff;
+        return true;
+    }
+    return false;
+}
+
+bool SocketLink::peer_transfer(uint8_t& value, size_t& done_at)
+{
+    read_messages(0);
+    if (!m_have_peer_transfer)
+    {
+        return false;
+    }
+    
+    m_have_peer_transfer = false;
+    value = m_peer_value;
+    done_at = m_peer_done_at;
+    return true;
+}
+
+void SocketLink::reply(uint8_t value)
+{
+    write_message(MSG_REPLY, value, 0);
+}
+
+bool SocketLink::sync(size_t curr_cycles)
+{
+    publish_cycles(curr_cycles);
+    read_messages(0);
+    
+    //m_peer_cycles is max once disconnected
+    if ((curr_cycles > m_window) && ((curr_cycles - m_window) > m_peer_cycles))
+    {
+        read_messages(WAIT_MS);
+        return false;
+    }
+    return true;
+}
+
+size_t SocketLink::sync_interval() const
+{
+    /*Often enough that a sync arrives before the other end reaches the
+     window, and that transfers from the other end are picked up soon
+     after they're sent. It waits for our reply.*/
+    return std::min(m_window / 2, MAX_SYNC_INTERVAL);
+}
+
+void SocketLink::disconnect()
+{
+    if (m_fd >= 0)
+    {
+        close(m_fd);
+        m_fd = -1;
+    }
+    m_peer_cycles = size_t(-1);
+}
+
+void SocketLink::publish_cycles(size_t curr_cycles)
+{
+    if (curr_cycles != m_published_cycles)
+    {
+        write_message(MSG_SYNC, 0, curr_cycles);
+        m_published_cycles = curr_cycles;
+    }
+}
+
+void SocketLink::write_message(MessageType type, uint8_t value, uint64_t cycles)
+{
+    if (m_fd < 0)
+    {
+        return;
+    }
+    
+    uint8_t message[MESSAGE_SIZE] = {uint8_t(type), value};
+    for (size_t i=0; i<8; ++i)
+    {
+        message[2+i] = uint8_t(cycles >> (i*8));
+    }
+    
+#ifdef MSG_NOSIGNAL
+    const int flags = MSG_NOSIGNAL;
+#else
+    const int flags = 0;
+#endif
+    
+    size_t written = 0;
+    while (written < MESSAGE_SIZE)
+    {
+        ssize_t ret = ::send(m_fd, message+written, MESSAGE_SIZE-written, flags);
+        if (ret > 0)
+        {
+            written += ret;
+        }
+        else if ((errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == EINTR))
+        {
+            pollfd p = {m_fd, POLLOUT, 0};
+            poll(&p, 1, WAIT_MS);
+        }
+        else
+        {
+            //The other end has gone away
+            disconnect();
+            return;
+        }
+    }
+}
+
+void SocketLink::read_messages(int timeout_ms)
+{
+    if (m_fd < 0)
+    {
+        return;
+    }
+    
+    if (timeout_ms)
+    {
+        pollfd p = {m_fd, POLLIN, 0};
+        poll(&p, 1, timeout_ms);
+    }
+    
+    uint8_t buf[256];
+    while (true)
+    {
+        ssize_t got = recv(m_fd, buf, sizeof(buf), 0);
+        if (got > 0)
+        {
+            m_read_buffer.insert(m_read_buffer.end(), buf, buf+got);
+        }
+        else if ((got < 0) && ((errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == EINTR)))
+        {
+            break;
+        }
+        else
+        {
+            //Closed, but handle anything it sent before that
+            disconnect();
+            break;
+        }
+    }
+    
+    size_t pos = 0;
+    for ( ; (m_read_buffer.size() - pos) >= MESSAGE_SIZE; pos += MESSAGE_SIZE)
+    {
+        const uint8_t* message = &m_read_buffer[pos];
+        uint64_t cycles = 0;
+        for (size_t i=0; i<8; ++i)
+        {
+            cycles |= uint64_t(message[2+i]) << (i*8);
+        }
+        
+        switch (message[0])
+        {
+            case MSG_SYNC:
+                if (m_fd >= 0)
+                {
+                    m_peer_cycles = cycles;
+                }
+                break;
+            case MSG_SEND:
+                m_have_peer_transfer = true;
+                m_peer_value = message[1];
+                m_peer_done_at = cycles;
+                break;
+            case MSG_REPLY:
+                m_have_reply = true;
+                m_reply = message[1];
+                break;
+            default:
+                throw std::runtime_error(formatted_string("Unknown link cable message type %u", message[0]));
+        }
+    }
+    m_read_buffer.erase(m_read_buffer.begin(), m_read_buffer.begin()+pos);
+}
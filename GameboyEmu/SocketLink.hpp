@@ -0,0 +1,82 @@
+//
+//  SocketLink.hpp
+//  GameboyEmu
+//
+//  Created by David Spickett on 18/10/2026.
+//  Copyright © 2026 David Spickett. All rights reserved.
+//
+
+#ifndef SocketLink_hpp
+#define SocketLink_hpp
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "SerialLink.hpp"
+
+/*A link cable to an emulator in another process on the same machine.
+ 
+ The address is a port number for loopback TCP, anything else is the
+ path of a UNIX domain socket. One end listens and the other connects.
+ 
+ Messages are only sent for each sync and at the start and end of a
+ transfer. Either end can run up to window clocks ahead of the last sync
+ it got from the other. Syncs are sent every window/2 clocks, so
+ with a window over 2048 clocks the other end can be more than a
+ transfer (4096 clocks) ahead and only hear about a transfer after its
+ done_at, in which case it answers straight away.*/
+class SocketLink: public SerialLink
+{
+public:
+    static std::unique_ptr<SocketLink> listen_on(const std::string& address, size_t window);
+    static std::unique_ptr<SocketLink> connect_to(const std::string& address, size_t window);
+    ~SocketLink();
+    
+    void send(uint8_t value, size_t done_at);
+    bool receive(size_t curr_cycles, uint8_t& value);
+    
+    bool peer_transfer(uint8_t& value, size_t& done_at);
+    void reply(uint8_t value);
+    
+    bool sync(size_t curr_cycles);
+    size_t sync_interval() const;
+    
+    void disconnect();
+    
+private:
+    SocketLink(int fd, size_t window);
+    
+    enum MessageType
+    {
+        //Cycles is the sender's cycle count
+        MSG_SYNC,
+        //Value is the sender's byte, cycles is done_at
+        MSG_SEND,
+        //Value is the answer to a MSG_SEND
+        MSG_REPLY,
+    };
+    
+    void write_message(MessageType type, uint8_t value, uint64_t cycles);
+    //Handle whatever has arrived, waiting up to timeout_ms if nothing has
+    void read_messages(int timeout_ms);
+    void publish_cycles(size_t curr_cycles);
+    
+    int m_fd;
+    size_t m_window;
+    
+    //From the last MSG_SYNC
+    size_t m_peer_cycles;
+    size_t m_published_cycles;
+    
+    bool m_have_peer_transfer;
+    uint8_t m_peer_value;
+    size_t m_peer_done_at;
+    
+    bool m_have_reply;
+    uint8_t m_reply;
+    
+    //Holds a partial message until the rest arrives
+    std::vector<uint8_t> m_read_buffer;
+};
+
+#endif /* SocketLink_hpp */
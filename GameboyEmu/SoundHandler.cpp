@@ -0,0 +1,559 @@
+//
+//  SoundHandler.cpp
+//  GameboyEmu
+//
+//  Created by David Spickett on 18/10/2026.
+//  Copyright © 2026 David Spickett. All rights reserved.
+//
+
+#include "SoundHandler.hpp"
+#include <algorithm>
+
+namespace
+{
+    const uint16_t NR10 = 0xff10;
+    const uint16_t NR11 = 0xff11;
+    const uint16_t NR12 = 0xff12;
+    const uint16_t NR13 = 0xff13;
+    const uint16_t NR14 = 0xff14;
+    const uint16_t NR21 = 0xff16;
+    const uint16_t NR22 = 0xff17;
+    const uint16_t NR23 = 0xff18;
+    const uint16_t NR24 = 0xff19;
+    const uint16_t NR30 = 0xff1a;
+    const uint16_t NR31 = 0xff1b;
+    const uint16_t NR32 = 0xff1c;
+    const uint16_t NR33 = 0xff1d;
+    const uint16_t NR34 = 0xff1e;
+    const uint16_t NR41 = 0xff20;
+    const uint16_t NR42 = 0xff21;
+    const uint16_t NR43 = 0xff22;
+    const uint16_t NR44 = 0xff23;
+    const uint16_t NR50 = 0xff24;
+    const uint16_t NR51 = 0xff25;
+    const uint16_t NR52 = 0xff26;
+    
+    const uint32_t CPU_CLOCK_RATE = 4194304;
+    //512Hz
+    const int FRAME_SEQUENCER_PERIOD = 8192;
+    
+    //Bits that always read as 1, from 0xff10 to 0xff2f
+    const std::array<uint8_t, WAVE_RAM_START-SOUND_BEGIN> READ_MASKS = {{
+        0x80, 0x3f, 0x00, 0xff, 0xbf,
+        0xff, 0x3f, 0x00, 0xff, 0xbf,
+        0x7f, 0xff, 0x9f, 0xff, 0xbf,
+        0xff, 0xff, 0x00, 0x00, 0xbf,
+        0x00, 0x00, 0x70,
+        0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    }};
+    
+    const uint8_t DUTY_CYCLES[4][8] = {
+        {0, 0, 0, 0, 0, 0, 0, 1}, //12.5%
+        {1, 0, 0, 0, 0, 0, 0, 1}, //25%
+        {1, 0, 0, 0, 0, 1, 1, 1}, //50%
+        {0, 1, 1, 1, 1, 1, 1, 0}, //75%
+    };
+    
+    const int NOISE_DIVISORS[8] = {8, 16, 32, 48, 64, 80, 96, 112};
+    
+    //Wave volume codes to the shift applied to each sample
+    const uint8_t WAVE_VOLUME_SHIFTS[4] = {4, 0, 1, 2};
+    
+    //How much of the filter's charge is kept each sample
+    const float CAPACITOR_CHARGE = 0.996f;
+    
+    int square_period(uint16_t frequency) { return (2048-frequency)*4; }
+    int wave_period(uint16_t frequency) { return (2048-frequency)*2; }
+    
+    //DACs map 0-15 to -1.0 to 1.0
+    float dac_output(bool dac_enabled, uint8_t value)
+    {
+        return dac_enabled ? (value / 7.5f) - 1.0f : 0.0f;
+    }
+    
+    float high_pass(float& capacitor, float in)
+    {
+        float out = in - capacitor;
+        capacitor = in - (out * CAPACITOR_CHARGE);
+        return out;
+    }
+}
+
+void ChannelEnvelope::clock()
+{
+    if (period == 0)
+    {
+        return;
+    }
+    
+    if (timer)
+    {
+        --timer;
+    }
+    
+    if (timer == 0)
+    {
+        timer = period;
+        if (increase && (volume < 15))
+        {
+            ++volume;
+        }
+        else if (!increase && (volume > 0))
+        {
+            --volume;
+        }
+    }
+}
+
+SoundHandler::SoundHandler():
+    m_samples(8192),
+    m_cycles(0),
+    m_synth_cycles(0),
+    m_sample_phase(0),
+    m_sample_step(AUDIO_SAMPLE_RATE),
+    m_frame_sequencer_timer(FRAME_SEQUENCER_PERIOD),
+    m_frame_sequencer_step(0),
+    m_power(false),
+    m_master_volume(0),
+    m_panning(0),
+    m_capacitor_left(0),
+    m_capacitor_right(0),
+    m_audio_device(0),
+    m_audio_opened(false)
+{
+    init_array(m_wave_ram);
+    init_array(m_regs);
+    m_batch.reserve(64);
+}
+
+SoundHandler::~SoundHandler()
+{
+    if (m_audio_device != 0)
+    {
+        SDL_CloseAudioDevice(m_audio_device);
+    }
+}
+
+void SoundHandler::open_audio()
+{
+    //Only try once, this is done when the game first turns sound on
+    if (m_audio_opened)
+    {
+        return;
+    }
+    m_audio_opened = true;
+    
+    //Carry on without sound rather than failing, e.g. on a machine without an audio device
+    if (SDL_InitSubSystem(SDL_INIT_AUDIO) < 0)
+    {
+        printf("SDL audio could not initialize, sound disabled. SDL_Error: %s\n", SDL_GetError());
+        return;
+    }
+    
+    SDL_AudioSpec want = SDL_AudioSpec();
+    want.freq = AUDIO_SAMPLE_RATE;
+    want.format = AUDIO_S16SYS;
+    want.channels = 2;
+    want.samples = 1024;
+    want.callback = audio_callback;
+    want.userdata = this;
+    
+    //SDL converts if the device wants a different format
+    m_audio_device = SDL_OpenAudioDevice(NULL, 0, &want, NULL, 0);
+    if (m_audio_device == 0)
+    {
+        printf("Could not open audio device, sound disabled. SDL_Error: %s\n", SDL_GetError());
+        return;
+    }
+    SDL_PauseAudioDevice(m_audio_device, 0);
+}
+
+void SoundHandler::audio_callback(void* userdata, Uint8* stream, int len)
+{
+    SoundHandler* sound = static_cast<SoundHandler*>(userdata);
+    AudioFrame* out = reinterpret_cast<AudioFrame*>(stream);
+    size_t count = len / sizeof(AudioFrame);
+    
+    size_t got = sound->m_samples.pop(out, count);
+    //Play silence if emulation has fallen behind
+    std::fill(out+got, out+count, AudioFrame());
+}
+
+uint8_t SoundHandler::read8(uint16_t addr)
+{
+    if (addr >= WAVE_RAM_START)
+    {
+        return m_wave_ram[addr-WAVE_RAM_START];
+    }
+    
+    if (addr == NR52)
+    {
+        //Channel status bits reflect the channels, not what was written
+        return READ_MASKS[addr-SOUND_BEGIN] |
+            (uint8_t(m_power) << 7) |
+            (uint8_t(m_noise.enabled) << 3) |
+            (uint8_t(m_wave.enabled) << 2) |
+            (uint8_t(m_square2.enabled) << 1) |
+            uint8_t(m_square1.enabled);
+    }
+    
+    return m_regs[addr-SOUND_BEGIN] | READ_MASKS[addr-SOUND_BEGIN];
+}
+
+void SoundHandler::write8(uint16_t addr, uint8_t value)
+{
+    //Bring the output up to date so that the change starts at the right time
+    synthesise(m_cycles);
+    
+    if (addr >= WAVE_RAM_START)
+    {
+        m_wave_ram[addr-WAVE_RAM_START] = value;
+        return;
+    }
+    
+    if (addr == NR52)
+    {
+        bool power = value & (1<<7);
+        if (m_power && !power)
+        {
+            power_off();
+        }
+        else if (!m_power && power)
+        {
+            m_frame_sequencer_step = 0;
+            open_audio();
+        }
+        m_power = power;
+        return;
+    }
+    
+    //Everything else is read only while powered off
+    if (!m_power)
+    {
+        return;
+    }
+    
+    m_regs[addr-SOUND_BEGIN] = value;
+    
+    switch (addr)
+    {
+        case NR10:
+            m_square1.sweep_period = (value >> 4) & 7;
+            m_square1.sweep_negate = value & (1<<3);
+            m_square1.sweep_shift = value & 7;
+            break;
+        case NR11:
+            m_square1.duty = value >> 6;
+            m_square1.length = 64 - (value & 0x3f);
+            break;
+        case NR21:
+            m_square2.duty = value >> 6;
+            m_square2.length = 64 - (value & 0x3f);
+            break;
+        case NR12:
+            m_square1.envelope.write(value);
+            m_square1.enabled &= m_square1.envelope.dac_enabled();
+            break;
+        case NR22:
+            m_square2.envelope.write(value);
+            m_square2.enabled &= m_square2.envelope.dac_enabled();
+            break;
+        case NR13:
+            m_square1.frequency = (m_square1.frequency & 0x700) | value;
+            break;
+        case NR23:
+            m_square2.frequency = (m_square2.frequency & 0x700) | value;
+            break;
+        case NR33:
+            m_wave.frequency = (m_wave.frequency & 0x700) | value;
+            break;
+        case NR14:
+        case NR24:
+        case NR34:
+        case NR44:
+        {
+            uint8_t channel = (addr-NR14) / 5;
+            SoundChannel& ch = (channel == 0) ? static_cast<SoundChannel&>(m_square1) :
+                               (channel == 1) ? static_cast<SoundChannel&>(m_square2) :
+                               (channel == 2) ? static_cast<SoundChannel&>(m_wave) :
+                                                static_cast<SoundChannel&>(m_noise);
+            //Noise has no frequency, it's set by NR43 instead
+            if (addr != NR44)
+            {
+                ch.frequency = (ch.frequency & 0xff) | ((value & 7) << 8);
+            }
+            ch.length_enabled = value & (1<<6);
+            if (value & (1<<7))
+            {
+                trigger(channel);
+            }
+            break;
+        }
+        case NR30:
+            m_wave.dac_enabled = value & (1<<7);
+            m_wave.enabled &= m_wave.dac_enabled;
+            break;
+        case NR31:
+            m_wave.length = 256 - value;
+            break;
+        case NR32:
+            m_wave.volume_shift = WAVE_VOLUME_SHIFTS[(value >> 5) & 3];
+            break;
+        case NR41:
+            m_noise.length = 64 - (value & 0x3f);
+            break;
+        case NR42:
+            m_noise.envelope.write(value);
+            m_noise.enabled &= m_noise.envelope.dac_enabled();
+            break;
+        case NR43:
+            m_noise.period = NOISE_DIVISORS[value & 7] << (value >> 4);
+            m_noise.short_mode = value & (1<<3);
+            break;
+        case NR50:
+            m_master_volume = value;
+            break;
+        case NR51:
+            m_panning = value;
+            break;
+        default:
+            break;
+    }
+}
+
+void SoundHandler::trigger(uint8_t channel)
+{
+    switch (channel)
+    {
+        case 0:
+        case 1:
+        {
+            SquareChannel& sq = (channel == 0) ? m_square1 : m_square2;
+            sq.enabled = sq.envelope.dac_enabled();
+            if (sq.length == 0)
+            {
+                sq.length = 64;
+            }
+            sq.timer = square_period(sq.frequency);
+            sq.envelope.trigger();
+            
+            if (channel == 0)
+            {
+                sq.shadow_frequency = sq.frequency;
+                sq.sweep_timer = sq.sweep_period ? sq.sweep_period : 8;
+                sq.sweep_enabled = sq.sweep_period || sq.sweep_shift;
+                if (sq.sweep_shift)
+                {
+                    //Only checks for overflow
+                    sweep_frequency();
+                }
+            }
+            break;
+        }
+        case 2:
+            m_wave.enabled = m_wave.dac_enabled;
+            if (m_wave.length == 0)
+            {
+                m_wave.length = 256;
+            }
+            m_wave.timer = wave_period(m_wave.frequency);
+            m_wave.position = 0;
+            break;
+        case 3:
+            m_noise.enabled = m_noise.envelope.dac_enabled();
+            if (m_noise.length == 0)
+            {
+                m_noise.length = 64;
+            }
+            m_noise.timer = m_noise.period;
+            m_noise.lfsr = 0x7fff;
+            m_noise.envelope.trigger();
+            break;
+    }
+}
+
+void SoundHandler::power_off()
+{
+    m_square1 = SquareChannel();
+    m_square2 = SquareChannel();
+    m_wave = WaveChannel();
+    m_noise = NoiseChannel();
+    m_master_volume = 0;
+    m_panning = 0;
+    init_array(m_regs);
+}
+
+uint16_t SoundHandler::sweep_frequency()
+{
+    uint16_t delta = m_square1.shadow_frequency >> m_square1.sweep_shift;
+    uint16_t frequency = m_square1.sweep_negate ?
+        m_square1.shadow_frequency - delta : m_square1.shadow_frequency + delta;
+    
+    if (frequency > 2047)
+    {
+        m_square1.enabled = false;
+    }
+    return frequency;
+}
+
+void SoundHandler::clock_frame_sequencer()
+{
+    //Length at 256Hz, sweep at 128Hz and envelope at 64Hz
+    if ((m_frame_sequencer_step & 1) == 0)
+    {
+        m_square1.clock_length();
+        m_square2.clock_length();
+        m_wave.clock_length();
+        m_noise.clock_length();
+    }
+    
+    if ((m_frame_sequencer_step == 2) || (m_frame_sequencer_step == 6))
+    {
+        if (m_square1.sweep_timer)
+        {
+            --m_square1.sweep_timer;
+        }
+        
+        if (m_square1.sweep_timer == 0)
+        {
+            m_square1.sweep_timer = m_square1.sweep_period ? m_square1.sweep_period : 8;
+            if (m_square1.sweep_enabled && m_square1.sweep_period)
+            {
+                uint16_t frequency = sweep_frequency();
+                if ((frequency <= 2047) && m_square1.sweep_shift)
+                {
+                    m_square1.frequency = frequency;
+                    m_square1.shadow_frequency = frequency;
+                    sweep_frequency();
+                }
+            }
+        }
+    }
+    
+    if (m_frame_sequencer_step == 7)
+    {
+        m_square1.envelope.clock();
+        m_square2.envelope.clock();
+        m_noise.envelope.clock();
+    }
+    
+    m_frame_sequencer_step = (m_frame_sequencer_step+1) & 7;
+}
+
+void SoundHandler::advance(int cycles)
+{
+    m_frame_sequencer_timer -= cycles;
+    if (m_frame_sequencer_timer <= 0)
+    {
+        m_frame_sequencer_timer += FRAME_SEQUENCER_PERIOD;
+        clock_frame_sequencer();
+    }
+    
+    if (m_square1.enabled)
+    {
+        for (m_square1.timer -= cycles; m_square1.timer <= 0; m_square1.timer += square_period(m_square1.frequency))
+        {
+            m_square1.position = (m_square1.position+1) & 7;
+        }
+    }
+    
+    if (m_square2.enabled)
+    {
+        for (m_square2.timer -= cycles; m_square2.timer <= 0; m_square2.timer += square_period(m_square2.frequency))
+        {
+            m_square2.position = (m_square2.position+1) & 7;
+        }
+    }
+    
+    if (m_wave.enabled)
+    {
+        for (m_wave.timer -= cycles; m_wave.timer <= 0; m_wave.timer += wave_period(m_wave.frequency))
+        {
+            m_wave.position = (m_wave.position+1) & 31;
+        }
+    }
+    
+    if (m_noise.enabled)
+    {
+        for (m_noise.timer -= cycles; m_noise.timer <= 0; m_noise.timer += m_noise.period)
+        {
+            uint16_t bit = (m_noise.lfsr ^ (m_noise.lfsr >> 1)) & 1;
+            m_noise.lfsr = (m_noise.lfsr >> 1) | (bit << 14);
+            if (m_noise.short_mode)
+            {
+                m_noise.lfsr = (m_noise.lfsr & ~(1<<6)) | (bit << 6);
+            }
+        }
+    }
+}
+
+void SoundHandler::mix_sample()
+{
+    float left = 0;
+    float right = 0;
+    
+    if (m_power)
+    {
+        std::array<float, 4> outputs = {{
+            dac_output(m_square1.envelope.dac_enabled(),
+                       m_square1.enabled && DUTY_CYCLES[m_square1.duty][m_square1.position] ? m_square1.envelope.volume : 0),
+            dac_output(m_square2.envelope.dac_enabled(),
+                       m_square2.enabled && DUTY_CYCLES[m_square2.duty][m_square2.position] ? m_square2.envelope.volume : 0),
+            dac_output(m_wave.dac_enabled,
+                       m_wave.enabled ? ((m_wave_ram[m_wave.position/2] >> ((m_wave.position & 1) ? 0 : 4)) & 0xf) >> m_wave.volume_shift : 0),
+            dac_output(m_noise.envelope.dac_enabled(),
+                       m_noise.enabled && !(m_noise.lfsr & 1) ? m_noise.envelope.volume : 0),
+        }};
+        
+        //NR51 bits 0-3 send each channel right, 4-7 left
+        for (size_t i=0; i<outputs.size(); ++i)
+        {
+            right += (m_panning & (1<<i)) ? outputs[i] : 0;
+            left += (m_panning & (1<<(i+4))) ? outputs[i] : 0;
+        }
+        
+        //Average the 4 channels then apply master volume, 1-8
+        left *= (((m_master_volume >> 4) & 7) + 1) / 32.0f;
+        right *= ((m_master_volume & 7) + 1) / 32.0f;
+    }
+    
+    //The filter can swing to +/-2 so leave room for that
+    AudioFrame frame;
+    frame.left = int16_t(high_pass(m_capacitor_left, left) * 16000);
+    frame.right = int16_t(high_pass(m_capacitor_right, right) * 16000);
+    m_batch.push_back(frame);
+}
+
+void SoundHandler::synthesise(size_t curr_cycles)
+{
+    size_t cycles = curr_cycles - m_synth_cycles;
+    m_synth_cycles = curr_cycles;
+    
+    while (cycles)
+    {
+        //Run up to the next sample point, at most ~95 cycles
+        uint32_t to_sample = (CPU_CLOCK_RATE - m_sample_phase + m_sample_step - 1) / m_sample_step;
+        uint32_t step = uint32_t(std::min(size_t(to_sample), cycles));
+        
+        if (m_power)
+        {
+            advance(step);
+        }
+        
+        m_sample_phase += step * m_sample_step;
+        cycles -= step;
+        
+        if (m_sample_phase >= CPU_CLOCK_RATE)
+        {
+            m_sample_phase -= CPU_CLOCK_RATE;
+            mix_sample();
+        }
+    }
+    
+    if (!m_batch.empty())
+    {
+        //Dropped if the audio thread isn't keeping up
+        m_samples.push(m_batch.data(), m_batch.size());
+        m_batch.clear();
+    }
+}
@@ -9,21 +9,209 @@
 #ifndef SoundHandler_h
 #define SoundHandler_h
 
+#include <SDL2/SDL.h>
+#include <vector>
 #include "MemoryManager.hpp"
+#include "RingBuffer.hpp"
 
+const uint16_t WAVE_RAM_START = 0xff30;
+const uint16_t WAVE_RAM_END   = 0xff40;
+
+const int AUDIO_SAMPLE_RATE = 44100;
+
+//Matches the layout SDL uses for 16 bit stereo
+struct AudioFrame
+{
+    int16_t left;
+    int16_t right;
+};
+
+//Length counter and volume envelope, shared by the channels that have them
+struct ChannelEnvelope
+{
+    ChannelEnvelope():
+        initial_volume(0), increase(false), period(0), volume(0), timer(0)
+    {}
+    
+    void write(uint8_t value)
+    {
+        initial_volume = value >> 4;
+        increase = value & (1<<3);
+        period = value & 7;
+    }
+    
+    void trigger()
+    {
+        volume = initial_volume;
+        timer = period;
+    }
+    
+    void clock();
+    
+    //If the top 5 bits are 0 the channel's DAC is off
+    bool dac_enabled() const { return (initial_volume != 0) || increase; }
+    
+    uint8_t initial_volume;
+    bool increase;
+    uint8_t period;
+    uint8_t volume;
+    uint8_t timer;
+};
+
+struct SoundChannel
+{
+    SoundChannel():
+        enabled(false), length_enabled(false), length(0),
+        frequency(0), timer(0), position(0)
+    {}
+    
+    void clock_length()
+    {
+        if (length_enabled && length)
+        {
+            --length;
+            if (length == 0)
+            {
+                enabled = false;
+            }
+        }
+    }
+    
+    bool enabled;
+    bool length_enabled;
+    uint16_t length;
+    uint16_t frequency;
+    //Clock cycles until the next waveform step
+    int timer;
+    uint8_t position;
+};
+
+struct SquareChannel: public SoundChannel
+{
+    SquareChannel():
+        duty(0), sweep_period(0), sweep_negate(false), sweep_shift(0),
+        sweep_timer(0), sweep_enabled(false), shadow_frequency(0)
+    {}
+    
+    uint8_t duty;
+    ChannelEnvelope envelope;
+    
+    //Sweep is only used by channel 1
+    uint8_t sweep_period;
+    bool sweep_negate;
+    uint8_t sweep_shift;
+    uint8_t sweep_timer;
+    bool sweep_enabled;
+    uint16_t shadow_frequency;
+};
+
+struct WaveChannel: public SoundChannel
+{
+    WaveChannel():
+        dac_enabled(false), volume_shift(4)
+    {}
+    
+    bool dac_enabled;
+    //0 is full volume, 4 is muted
+    uint8_t volume_shift;
+};
+
+struct NoiseChannel: public SoundChannel
+{
+    NoiseChannel():
+        period(8), lfsr(0x7fff), short_mode(false)
+    {}
+    
+    ChannelEnvelope envelope;
+    int period;
+    uint16_t lfsr;
+    bool short_mode;
+};
+
+/*Emulates the 4 sound channels and mixes them to 16 bit stereo samples.
+ Samples are made in batches, either once a quantum of cycles has passed or
+ before a register write changes the output. They are handed to the SDL audio
+ thread through a lock free ring buffer.*/
 class SoundHandler : public MemoryManager
 {
 public:
-    SoundHandler()
-    {}
+    SoundHandler();
+    ~SoundHandler();
+    
+    uint8_t read8(uint16_t addr);
+    void write8(uint16_t addr, uint8_t value);
+    
+    uint16_t read16(uint16_t addr) { return read8(addr) | (read8(addr+1) << 8); }
+    void write16(uint16_t addr, uint16_t value)
+    {
+        write8(addr, value);
+        write8(addr+1, value >> 8);
+    }
+    
+    void tick(size_t curr_cycles)
+    {
+        m_cycles = curr_cycles;
+        if ((curr_cycles - m_synth_cycles) >= SYNTH_QUANTUM)
+        {
+            synthesise(curr_cycles);
+        }
+    }
+    
+    //True once an audio device is consuming m_samples
+    bool audio_running() const { return m_audio_device != 0; }
+    
+    /*Scale the number of samples made per emulated second, to stop the
+     buffer slowly filling or draining when the emulated and audio clocks drift.*/
+    void set_rate_ratio(double ratio) { m_sample_step = uint32_t((AUDIO_SAMPLE_RATE*ratio) + 0.5); }
+    
+    //Samples waiting to be played
+    RingBuffer<AudioFrame> m_samples;
+    
+private:
+    //About 1ms, around 43 samples per batch
+    static const size_t SYNTH_QUANTUM = 4096;
+    
+    void synthesise(size_t curr_cycles);
+    void advance(int cycles);
+    void clock_frame_sequencer();
+    void mix_sample();
+    
+    uint16_t sweep_frequency();
+    void trigger(uint8_t channel);
+    void power_off();
+    void open_audio();
+    
+    static void audio_callback(void* userdata, Uint8* stream, int len);
+    
+    size_t m_cycles;
+    size_t m_synth_cycles;
+    //Accumulates m_sample_step per cycle, a sample is due when it reaches the CPU clock rate
+    uint32_t m_sample_phase;
+    //Nominally AUDIO_SAMPLE_RATE
+    uint32_t m_sample_step;
+    int m_frame_sequencer_timer;
+    uint8_t m_frame_sequencer_step;
+    
+    bool m_power;
+    uint8_t m_master_volume;
+    uint8_t m_panning;
+    
+    SquareChannel m_square1;
+    SquareChannel m_square2;
+    WaveChannel m_wave;
+    NoiseChannel m_noise;
+    std::array<uint8_t, WAVE_RAM_END-WAVE_RAM_START> m_wave_ram;
     
-    uint8_t read8(uint16_t addr) { return 0; }
-    void write8(uint16_t addr, uint8_t value) {}
+    //Raw register values, for reading back
+    std::array<uint8_t, WAVE_RAM_START-SOUND_BEGIN> m_regs;
     
-    uint16_t read16(uint16_t addr) { return 0; }
-    void write16(uint16_t addr, uint16_t value) {}
+    //High pass filter state, removes the DC offset of the DACs
+    float m_capacitor_left;
+    float m_capacitor_right;
     
-    void tick(size_t curr_cycles) {}
+    std::vector<AudioFrame> m_batch;
+    SDL_AudioDeviceID m_audio_device;
+    bool m_audio_opened;
 };
 
 #endif /* SoundHandler_h */
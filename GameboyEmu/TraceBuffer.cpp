@@ -0,0 +1,97 @@
+//
+//  TraceBuffer.cpp
+//  GameboyEmu
+//
+//  Created by David Spickett on 18/10/2026.
+//  Copyright © 2026 David Spickett. All rights reserved.
+//
+
+#include "TraceBuffer.hpp"
+#include <fstream>
+#include <stdexcept>
+#include "utils.hpp"
+
+namespace
+{
+    struct TraceFileHeader
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t record_size;
+        uint64_t num_records;
+    };
+    
+    const char TRACE_MAGIC[8] = {'G', 'B', 'T', 'R', 'A', 'C', 'E', '\0'};
+    const uint32_t TRACE_VERSION = 1;
+}
+
+TraceBuffer::TraceBuffer(size_t num_records):
+    m_count(0),
+    m_scratch()
+{
+    size_t size = 1;
+    while (size < num_records)
+    {
+        size <<= 1;
+    }
+    m_records = std::vector<TraceRecord>(size, TraceRecord());
+    m_mask = size-1;
+    m_current = &m_scratch;
+}
+
+std::vector<TraceRecord> TraceBuffer::records() const
+{
+    std::vector<TraceRecord> ret;
+    uint64_t first = m_count > m_records.size() ? m_count-m_records.size() : 0;
+    for (uint64_t i=first; i<m_count; ++i)
+    {
+        ret.push_back(m_records[i & m_mask]);
+    }
+    return ret;
+}
+
+void TraceBuffer::Dump(const std::string& path) const
+{
+    std::ofstream out(path.c_str(), std::ofstream::binary);
+    if (!out.is_open())
+    {
+        throw std::runtime_error(formatted_string("Could not open %s for writing.", path.c_str()));
+    }
+    
+    std::vector<TraceRecord> recs = records();
+    TraceFileHeader header;
+    std::copy(std::begin(TRACE_MAGIC), std::end(TRACE_MAGIC), header.magic);
+    header.version = TRACE_VERSION;
+    header.record_size = sizeof(TraceRecord);
+    header.num_records = recs.size();
+    
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(recs.data()), recs.size()*sizeof(TraceRecord));
+}
+
+std::vector<TraceRecord> ReadTrace(const std::string& path)
+{
+    std::ifstream in(path.c_str(), std::ifstream::binary);
+    if (!in.is_open())
+    {
+        throw std::runtime_error(formatted_string("File %s does not exist.", path.c_str()));
+    }
+    
+    TraceFileHeader header;
+    in.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!in ||
+        !std::equal(std::begin(TRACE_MAGIC), std::end(TRACE_MAGIC), header.magic) ||
+        (header.version != TRACE_VERSION) ||
+        (header.record_size != sizeof(TraceRecord)))
+    {
+        throw std::runtime_error(formatted_string("%s is not a supported trace file.", path.c_str()));
+    }
+    
+    std::vector<TraceRecord> recs(header.num_records);
+    in.read(reinterpret_cast<char*>(recs.data()), recs.size()*sizeof(TraceRecord));
+    if (!in)
+    {
+        throw std::runtime_error(formatted_string("Trace file %s is truncated.", path.c_str()));
+    }
+    return recs;
+}
@@ -0,0 +1,81 @@
+//
+//  TraceBuffer.hpp
+//  GameboyEmu
+//
+//  Created by David Spickett on 18/10/2026.
+//  Copyright © 2026 David Spickett. All rights reserved.
+//
+
+#ifndef TraceBuffer_hpp
+#define TraceBuffer_hpp
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+//State before an instruction ran, plus the bytes fetched for it
+struct TraceRecord
+{
+    uint64_t cycle;
+    uint16_t pc;
+    uint16_t af;
+    uint16_t bc;
+    uint16_t de;
+    uint16_t hl;
+    uint16_t sp;
+    uint8_t bytes[3];
+    uint8_t length;
+};
+
+static_assert(sizeof(TraceRecord) == 24, "Trace files rely on the record layout.");
+
+/*Keeps the last N instructions executed in a ring buffer. Dumped files
+ are a header followed by the raw records, oldest first, in host byte
+ order. Decode them with GameboyEmuTrace.*/
+class TraceBuffer
+{
+public:
+    //Size is rounded up to a power of 2
+    explicit TraceBuffer(size_t num_records=1<<16);
+    
+    void begin(uint64_t cycle, uint16_t pc, uint16_t af, uint16_t bc,
+               uint16_t de, uint16_t hl, uint16_t sp)
+    {
+        TraceRecord& r = m_records[m_count & m_mask];
+        ++m_count;
+        r.cycle = cycle;
+        r.pc = pc;
+        r.af = af;
+        r.bc = bc;
+        r.de = de;
+        r.hl = hl;
+        r.sp = sp;
+        r.length = 0;
+        m_current = &r;
+    }
+    
+    void add_byte(uint8_t byte)
+    {
+        //Interrupt dispatch doesn't fetch, so this can't overrun
+        if (m_current->length < sizeof(m_current->bytes))
+        {
+            m_current->bytes[m_current->length++] = byte;
+        }
+    }
+    
+    void Dump(const std::string& path) const;
+    //Records in the order they were written
+    std::vector<TraceRecord> records() const;
+    
+private:
+    std::vector<TraceRecord> m_records;
+    size_t m_mask;
+    uint64_t m_count;
+    TraceRecord* m_current;
+    //Target of add_byte before the first begin
+    TraceRecord m_scratch;
+};
+
+std::vector<TraceRecord> ReadTrace(const std::string& path);
+
+#endif /* TraceBuffer_hpp */
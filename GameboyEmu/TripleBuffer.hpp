@@ -0,0 +1,60 @@
+//
+//  TripleBuffer.hpp
+//  GameboyEmu
+//
+//  Created by David Spickett on 18/10/2026.
+//  Copyright © 2026 David Spickett. All rights reserved.
+//
+
+#ifndef TripleBuffer_hpp
+#define TripleBuffer_hpp
+
+#include <stdint.h>
+#include <atomic>
+
+/*Passes the latest value from one producer thread to one consumer thread
+ without locking. The producer fills back() then publishes it, the consumer
+ calls update() then reads front(). Neither ever waits for the other, if the
+ producer is faster the consumer just sees the newest value.*/
+template <class T> class TripleBuffer
+{
+public:
+    TripleBuffer():
+        m_back(0),
+        m_middle(1),
+        m_front(2)
+    {}
+    
+    //Producer side
+    T& back() { return m_buffers[m_back]; }
+    
+    void publish()
+    {
+        m_back = m_middle.exchange(m_back | NEW_DATA, std::memory_order_acq_rel) & INDEX_MASK;
+    }
+    
+    //Consumer side, returns true if there was a new value
+    bool update()
+    {
+        if (!(m_middle.load(std::memory_order_relaxed) & NEW_DATA))
+        {
+            return false;
+        }
+        m_front = m_middle.exchange(m_front, std::memory_order_acq_rel) & INDEX_MASK;
+        return true;
+    }
+    
+    const T& front() const { return m_buffers[m_front]; }
+    
+private:
+    static const uint8_t NEW_DATA   = 1<<2;
+    static const uint8_t INDEX_MASK = 3;
+    
+    T m_buffers[3];
+    uint8_t m_back;
+    //Index of the spare buffer, with NEW_DATA set if it was published but not yet taken
+    std::atomic<uint8_t> m_middle;
+    uint8_t m_front;
+};
+
+#endif /* TripleBuffer_hpp */
@@ -0,0 +1,279 @@
+//
+//  Upscaler.cpp
+//  GameboyEmu
+//
+//  Created by David Spickett on 18/10/2026.
+//  Copyright © 2026 David Spickett. All rights reserved.
+//
+
+#include "Upscaler.hpp"
+#include "utils.hpp"
+#include <string.h>
+#include <stdexcept>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+    inline uint32_t* row_at(uint32_t* pixels, size_t pitch, size_t y)
+    {
+        return reinterpret_cast<uint32_t*>(reinterpret_cast<uint8_t*>(pixels) + y*pitch);
+    }
+    
+    //Repeat each pixel of a row factor times
+    void widen_row(const uint32_t* in, size_t width, uint32_t* out, int factor)
+    {
+        size_t x = 0;
+#if defined(__SSE2__)
+        //4 pixels at a time for the common scales
+        if (factor == 2)
+        {
+            for ( ; (x+4)<=width; x+=4, out+=8)
+            {
+                __m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in+x));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out),   _mm_unpacklo_epi32(p, p));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out+4), _mm_unpackhi_epi32(p, p));
+            }
+        }
+        else if (factor == 3)
+        {
+            for ( ; (x+4)<=width; x+=4, out+=12)
+            {
+                __m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in+x));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out),   _mm_shuffle_epi32(p, _MM_SHUFFLE(1, 0, 0, 0)));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out+4), _mm_shuffle_epi32(p, _MM_SHUFFLE(2, 2, 1, 1)));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out+8), _mm_shuffle_epi32(p, _MM_SHUFFLE(3, 3, 3, 2)));
+            }
+        }
+        else if (factor >= 4)
+        {
+            for ( ; x<width; ++x)
+            {
+                __m128i p = _mm_set1_epi32(int(in[x]));
+                int i = 0;
+                for ( ; (i+4)<=factor; i+=4, out+=4)
+                {
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(out), p);
+                }
+                for ( ; i<factor; ++i, ++out)
+                {
+                    *out = in[x];
+                }
+            }
+        }
+#endif
+        for ( ; x<width; ++x)
+        {
+            for (int i=0; i<factor; ++i, ++out)
+            {
+                *out = in[x];
+            }
+        }
+    }
+    
+    void scale_nearest(const uint32_t* in, size_t width, size_t height,
+                       uint32_t* out, size_t out_pitch, int factor)
+    {
+        const size_t out_row_bytes = width*factor*sizeof(uint32_t);
+        for (size_t y=0; y<height; ++y, in+=width)
+        {
+            uint32_t* first = row_at(out, out_pitch, y*factor);
+            widen_row(in, width, first, factor);
+            for (int i=1; i<factor; ++i)
+            {
+                memcpy(row_at(out, out_pitch, y*factor + i), first, out_row_bytes);
+            }
+        }
+    }
+    
+    //Half brightness, keeping alpha
+    void darken_row(uint32_t* row, size_t width)
+    {
+        size_t x = 0;
+#if defined(__SSE2__)
+        const __m128i mask  = _mm_set1_epi32(0x007f7f7f);
+        const __m128i alpha = _mm_set1_epi32(int(0xff000000));
+        for ( ; (x+4)<=width; x+=4)
+        {
+            __m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row+x));
+            p = _mm_or_si128(_mm_and_si128(_mm_srli_epi32(p, 1), mask), alpha);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(row+x), p);
+        }
+#endif
+        for ( ; x<width; ++x)
+        {
+            row[x] = ((row[x] >> 1) & 0x007f7f7f) | 0xff000000;
+        }
+    }
+    
+    /*Scale2x and Scale3x, see http://www.scale2x.it/algorithm
+     Neighbours are named:
+     A B C
+     D E F
+     G H I
+     Pixels off the edge are taken to be the same as the nearest one.*/
+    void scale2x(const uint32_t* in, size_t width, size_t height, uint32_t* out, size_t out_pitch)
+    {
+        for (size_t y=0; y<height; ++y)
+        {
+            const uint32_t* row   = in + y*width;
+            const uint32_t* above = y ? row-width : row;
+            const uint32_t* below = (y+1)<height ? row+width : row;
+            uint32_t* out0 = row_at(out, out_pitch, y*2);
+            uint32_t* out1 = row_at(out, out_pitch, y*2 + 1);
+            
+            for (size_t x=0; x<width; ++x)
+            {
+                const size_t left  = x ? x-1 : x;
+                const size_t right = (x+1)<width ? x+1 : x;
+                const uint32_t B = above[x], D = row[left], E = row[x], F = row[right], H = below[x];
+                
+                uint32_t E0 = E, E1 = E, E2 = E, E3 = E;
+                if ((B != H) && (D != F))
+                {
+                    E0 = D == B ? D : E;
+                    E1 = B == F ? F : E;
+                    E2 = D == H ? D : E;
+                    E3 = H == F ? F : E;
+                }
+                out0[x*2] = E0;
+                out0[x*2 + 1] = E1;
+                out1[x*2] = E2;
+                out1[x*2 + 1] = E3;
+            }
+        }
+    }
+    
+    void scale3x(const uint32_t* in, size_t width, size_t height, uint32_t* out, size_t out_pitch)
+    {
+        for (size_t y=0; y<height; ++y)
+        {
+            const uint32_t* row   = in + y*width;
+            const uint32_t* above = y ? row-width : row;
+            const uint32_t* below = (y+1)<height ? row+width : row;
+            uint32_t* out0 = row_at(out, out_pitch, y*3);
+            uint32_t* out1 = row_at(out, out_pitch, y*3 + 1);
+            uint32_t* out2 = row_at(out, out_pitch, y*3 + 2);
+            
+            for (size_t x=0; x<width; ++x)
+            {
+                const size_t left  = x ? x-1 : x;
+                const size_t right = (x+1)<width ? x+1 : x;
+                const uint32_t A = above[left], B = above[x], C = above[right];
+                const uint32_t D = row[left],   E = row[x],   F = row[right];
+                const uint32_t G = below[left], H = below[x], I = below[right];
+                
+                uint32_t E0 = E, E1 = E, E2 = E, E3 = E, E5 = E, E6 = E, E7 = E, E8 = E;
+                if ((B != H) && (D != F))
+                {
+                    E0 = D == B ? D : E;
+                    E1 = ((D == B) && (E != C)) || ((B == F) && (E != A)) ? B : E;
+                    E2 = B == F ? F : E;
+                    E3 = ((D == B) && (E != G)) || ((D == H) && (E != A)) ? D : E;
+                    E5 = ((B == F) && (E != I)) || ((H == F) && (E != C)) ? F : E;
+                    E6 = D == H ? D : E;
+                    E7 = ((D == H) && (E != I)) || ((H == F) && (E != G)) ? H : E;
+                    E8 = H == F ? F : E;
+                }
+                out0[x*3] = E0;
+                out0[x*3 + 1] = E1;
+                out0[x*3 + 2] = E2;
+                out1[x*3] = E3;
+                out1[x*3 + 1] = E;
+                out1[x*3 + 2] = E5;
+                out2[x*3] = E6;
+                out2[x*3 + 1] = E7;
+                out2[x*3 + 2] = E8;
+            }
+        }
+    }
+}
+
+ScaleFilter parse_scale_filter(const std::string& name)
+{
+    if (name == "nearest")
+    {
+        return FILTER_NEAREST;
+    }
+    else if (name == "scale2x")
+    {
+        return FILTER_SCALE2X;
+    }
+    else if (name == "scale3x")
+    {
+        return FILTER_SCALE3X;
+    }
+    else if (name == "scanlines")
+    {
+        return FILTER_SCANLINES;
+    }
+    throw std::runtime_error(formatted_string("Unknown filter \"%s\". (expected nearest, scale2x, scale3x or scanlines)", name.c_str()));
+}
+
+Upscaler::Upscaler(ScaleFilter filter, int factor):
+    m_filter(filter),
+    m_factor(factor)
+{
+    if (factor < 1)
+    {
+        throw std::runtime_error(formatted_string("Scale must be at least 1, got %d.", factor));
+    }
+    
+    int base = 1;
+    if (filter == FILTER_SCALE2X)
+    {
+        base = 2;
+    }
+    else if (filter == FILTER_SCALE3X)
+    {
+        base = 3;
+    }
+    if (factor % base)
+    {
+        throw std::runtime_error(formatted_string("Filter needs a scale that is a multiple of %d, got %d.", base, factor));
+    }
+    
+    if ((base != 1) && (factor != base))
+    {
+        m_temp.resize(LCD_WIDTH*LCD_HEIGHT*base*base);
+    }
+}
+
+void Upscaler::scale(const uint32_t* in, uint32_t* out, size_t out_pitch)
+{
+    switch (m_filter)
+    {
+        case FILTER_NEAREST:
+            scale_nearest(in, LCD_WIDTH, LCD_HEIGHT, out, out_pitch, m_factor);
+            break;
+        case FILTER_SCANLINES:
+            scale_nearest(in, LCD_WIDTH, LCD_HEIGHT, out, out_pitch, m_factor);
+            if (m_factor > 1)
+            {
+                for (size_t y=m_factor-1; y<(LCD_HEIGHT*m_factor); y+=m_factor)
+                {
+                    darken_row(row_at(out, out_pitch, y), LCD_WIDTH*m_factor);
+                }
+            }
+            break;
+        case FILTER_SCALE2X:
+        case FILTER_SCALE3X:
+        {
+            const int base = (m_filter == FILTER_SCALE2X) ? 2 : 3;
+            auto smooth = (m_filter == FILTER_SCALE2X) ? scale2x : scale3x;
+            if (m_factor == base)
+            {
+                smooth(in, LCD_WIDTH, LCD_HEIGHT, out, out_pitch);
+            }
+            else
+            {
+                //Smooth then make the result bigger
+                const size_t width = LCD_WIDTH*base;
+                smooth(in, LCD_WIDTH, LCD_HEIGHT, m_temp.data(), width*sizeof(uint32_t));
+                scale_nearest(m_temp.data(), width, LCD_HEIGHT*base, out, out_pitch, m_factor/base);
+            }
+            break;
+        }
+    }
+}
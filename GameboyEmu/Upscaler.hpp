@@ -0,0 +1,45 @@
+//
+//  Upscaler.hpp
+//  GameboyEmu
+//
+//  Created by David Spickett on 18/10/2026.
+//  Copyright © 2026 David Spickett. All rights reserved.
+//
+
+#ifndef Upscaler_hpp
+#define Upscaler_hpp
+
+#include "LCDFrame.hpp"
+#include <string>
+#include <vector>
+
+enum ScaleFilter {
+    //Each pixel becomes a square
+    FILTER_NEAREST,
+    //Smooth diagonal edges, for scales that are a multiple of 2 or 3
+    FILTER_SCALE2X,
+    FILTER_SCALE3X,
+    //Nearest with the bottom row of each pixel darkened, like a CRT
+    FILTER_SCANLINES,
+};
+
+ScaleFilter parse_scale_filter(const std::string& name);
+
+/*Scales whole frames of LCD_WIDTH x LCD_HEIGHT ARGB8888 pixels by a whole
+ number, on the CPU so that SDL only has to copy the result.*/
+class Upscaler
+{
+public:
+    Upscaler(ScaleFilter filter, int factor);
+    
+    //out is factor times the size of the LCD, pitch is in bytes
+    void scale(const uint32_t* in, uint32_t* out, size_t out_pitch);
+    
+private:
+    ScaleFilter m_filter;
+    int m_factor;
+    //Output of Scale2x/3x when nearest scaling comes after
+    std::vector<uint32_t> m_temp;
+};
+
+#endif /* Upscaler_hpp */
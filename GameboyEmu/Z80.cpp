@@ -7,6 +7,7 @@
 //
 
 #include "Z80.hpp"
+#include "TraceBuffer.hpp"
 #include <string>
 
 std::string FlagRegister::to_string()
@@ -39,6 +40,16 @@ void Z80::skip_bootstrap()
     mem.write8(0xff40, 0x91);
 }
 
+void Z80::prefetch()
+{
+    //Registers and the other members used by every Step()
+    ::prefetch(this);
+    ::prefetch(&mem);
+    //Code about to run and the top of the stack
+    mem.prefetch(pc.read());
+    mem.prefetch(sp.read());
+}
+
 void Z80::post_interrupt(uint8_t num)
 {
     if (num > 5)
@@ -72,7 +83,7 @@ void Z80::post_interrupt(uint8_t num)
     
 }
 
-void Z80::tick(uint8_t cycles)
+void Z80::tick(uint32_t cycles)
 {
     m_total_cycles += cycles;
     mem.tick(m_total_cycles);
@@ -82,6 +93,10 @@ uint8_t Z80::fetch_byte()
 {
     uint8_t ret = mem.read8(pc.read());
     pc.inc(1);
+    if (m_trace)
+    {
+        m_trace->add_byte(ret);
+    }
     return ret;
 }
 
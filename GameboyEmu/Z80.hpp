@@ -11,17 +11,20 @@
 
 #include "MemoryMap.hpp"
 
+class Profiler;
+class TraceBuffer;
+
 template <class int_type> class Register
 {
 public:
     explicit Register(std::string name_str):
-        m_value(0), logging(false)
+        m_value(0)
     {
         strncpy(name, name_str.c_str(), 3);
     }
     
     Register(int_type value, std::string name_str):
-        m_value(value), logging(false)
+        m_value(value)
     {
         strncpy(name, name_str.c_str(), 3);
     }
@@ -30,35 +33,19 @@ public:
     virtual void write(int_type val)
     {
         m_value = val;
-        
-        if (logging)
-        {
-            printf("Reg: %s new value: 0x%x\n", name, val);
-        }
     }
     
     void inc(int_type val)
     {
         m_value+=val;
-        
-        if (logging)
-        {
-            printf("Reg: %s inc by %d to: 0x%x\n", name, val, m_value);
-        }
     }
     
     void dec(int_type val)
     {
         m_value-=val;
-        
-        if (logging)
-        {
-            printf("Reg: %s dec by %d to: 0x%x\n", name, val, m_value);
-        }
     }
     
     char name[3];
-    bool logging;
     
 protected:
     int_type m_value;
@@ -75,11 +62,6 @@ public:
     {
         //You can't write the bottom 4 bits of the flag register!
         m_value = val & 0xf0;
-        
-        if (logging)
-        {
-            printf("Reg: %s new value: 0x%x\n", name, val);
-        }
     }
     
     bool get_z() { return get_bit(7); }
@@ -120,6 +102,8 @@ public:
         interrupt_enable(false),
         halted(false),
         stopped(false),
+        m_profiler(nullptr),
+        m_trace(nullptr),
         m_interrupt_addrs{0x0040, 0x0048, 0x0050, 0x0058, 0x0060}
     {}
     
@@ -152,17 +136,25 @@ public:
     
     std::string status_string();
     
-    void tick(uint8_t cycles);
+    void tick(uint32_t cycles);
     
     void post_interrupt(uint8_t num);
     void skip_bootstrap();
     
+    //Warm the cache before this processor is next stepped
+    void prefetch();
+    
     bool interrupt_enable;
     bool halted;
     bool stopped;
     
     size_t m_total_cycles;
     
+    //Set to record where guest cycles are spent
+    Profiler* m_profiler;
+    //Set to record recently executed instructions
+    TraceBuffer* m_trace;
+    
 private:
     std::array<uint16_t, 5> m_interrupt_addrs;
     
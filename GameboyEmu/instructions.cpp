@@ -8,26 +8,10 @@
 
 #include "instructions.hpp"
 #include <iostream>
+#include <algorithm>
 #include "utils.hpp"
-
-#define DEBUG_INSTR 0
-int print = 0;
-
-namespace
-{
-#if DEBUG_INSTR
-   template< typename... Args >
-    void debug_print(const char* format, Args... args)
-    {
-        if (print)
-        {
-            printf(format, args...);
-        }
-    }
-#else
-#define debug_print(...)
-#endif
-}
+#include "Profiler.hpp"
+#include "TraceBuffer.hpp"
 
 namespace
 {
@@ -104,7 +88,6 @@ inline uint8_t add_a_n(Z80& proc, uint8_t b1)
     InstrArg arg = get_single_arg(proc, b1);
     generic_add_a_n(proc, arg.value);
     
-    debug_print("add a, %s\n", arg.name);
     return 4;
 }
 
@@ -123,7 +106,6 @@ inline uint8_t sub_n(Z80& proc, uint8_t b1)
     
     proc.a.write(new_value);
     
-    debug_print("sub %s\n", arg.name);
     return arg.cycles;
 }
 
@@ -133,7 +115,6 @@ inline uint8_t ldh_a_n(Z80& proc)
     uint16_t addr = 0xff00 + offs;
     proc.a.write(proc.mem.read8(addr));
     
-    debug_print("ldh a, (0xff00+0x%02x)\n", offs);
     return 12;
 }
 
@@ -144,7 +125,6 @@ inline uint8_t jr_n(Z80& proc)
     //We jump from the address of the next instr, not the jr itself.
     proc.pc.write(proc.pc.read()+offs);
     
-    debug_print("jr 0x%02x (%d)\n", uint8_t(offs), offs);
     return 8;
 }
 
@@ -160,8 +140,6 @@ inline uint8_t cp_n(Z80& proc, uint8_t b1)
     proc.f.set_h((a & 0xF) > (arg.value & 0xF));
     proc.f.set_c(a < arg.value);
     
-    debug_print("cp %s\n", arg.name);
-    
     return arg.cycles;
 }
 
@@ -172,7 +150,6 @@ inline uint8_t ret(Z80& proc)
     proc.sp.inc(2);
     proc.pc.write(new_addr);
     
-    debug_print("%s", "ret\n");
     return 8;
 }
 
@@ -200,7 +177,6 @@ inline uint8_t inc_nn(Z80& proc, uint8_t b1)
             break;
     }
 
-    debug_print("inc %s\n", pair.c_str());
     return 8;
 }
 
@@ -212,7 +188,6 @@ inline uint8_t ld_hl_plus_a(Z80& proc)
     //inc (hl)
     proc.set_hl(hl+1);
     
-    debug_print("%s", "ld (hl+), a\n");
     return 8;
 }
 
@@ -264,7 +239,6 @@ inline uint8_t dec_n(Z80& proc, uint8_t b1)
             uint8_t new_val = generic_dec_n(proc, proc.mem.read8(addr));
             proc.mem.write8(addr, new_val);
             
-            debug_print("%s", "dec (hl)\n");
             return 12;
         }
     }
@@ -272,7 +246,6 @@ inline uint8_t dec_n(Z80& proc, uint8_t b1)
     uint8_t new_val = generic_dec_n(proc, reg->read());
     reg->write(new_val);
     
-    debug_print("dec %s\n", reg->name);
     return 4;
 }
 
@@ -302,7 +275,6 @@ inline uint8_t pop_nn(Z80& proc, uint8_t b1)
             break;
     }
     
-    debug_print("pop (%s)\n", pair.c_str());
     return 12;
 }
 
@@ -330,7 +302,6 @@ inline uint8_t rla(Z80& proc)
     uint8_t new_val = generic_rl_n(proc, proc.a.read());
     proc.a.write(new_val);
     
-    debug_print("%s", "rla\n");
     return 4;
 }
 
@@ -363,7 +334,6 @@ inline uint8_t push_nn(Z80& proc, uint8_t b1)
     proc.sp.dec(2);
     proc.mem.write16(proc.sp.read(), value);
     
-    debug_print("push %s\n", pair.c_str());
     return 16;
 }
 
@@ -378,7 +348,6 @@ inline uint8_t call_nn(Z80& proc)
     
     proc.pc.write(j_addr);
     
-    debug_print("call 0x%02x\n", j_addr);
     return 12;
 }
 
@@ -387,7 +356,6 @@ inline uint8_t ld_offs_n_a(Z80& proc)
     uint16_t addr = 0xff00 + proc.fetch_byte();
     proc.mem.write8(addr, proc.a.read());
     
-    debug_print("ldh (0x%02x), a\n", addr);
     return 12;
 }
 
@@ -444,7 +412,6 @@ inline uint8_t ld_n_a(Z80& proc, uint8_t b1)
             
             proc.mem.write8(addr, proc.a.read());
             
-            debug_print("ld %s, a\n", r_name.c_str());
             return 8;
         }
         case 0xea:
@@ -453,14 +420,12 @@ inline uint8_t ld_n_a(Z80& proc, uint8_t b1)
             uint16_t addr = proc.fetch_short();
             proc.mem.write8(addr, proc.a.read());
             
-            debug_print("ld (0x%02x), a\n", addr);
             return 16;
         }
     }
     
     reg->write(proc.a.read());
     
-    debug_print("ld %s, a\n", reg->name);
     return 4;
 }
                      
@@ -516,8 +481,6 @@ inline uint8_t inc_n(Z80& proc, uint8_t b1)
             uint8_t new_val = generic_inc_n(proc, orig_val);
             proc.mem.write8(addr, new_val);
             
-            debug_print("%s", "inc (hl)\n");
-            
             return 12;
         }
     }
@@ -526,7 +489,6 @@ inline uint8_t inc_n(Z80& proc, uint8_t b1)
     uint8_t new_val = generic_inc_n(proc, orig_val);
     reg->write(new_val);
     
-    debug_print("inc %s\n", reg->name);
     return 4;
 }
 
@@ -535,7 +497,6 @@ inline uint8_t ld_offs_c_a(Z80& proc)
     uint16_t addr = 0xff00 + proc.c.read();
     proc.mem.write8(addr, proc.a.read());
     
-    debug_print("%s", "ld (c), a\n");
     return 8;
 }
 
@@ -620,8 +581,6 @@ inline uint8_t ld_a_n(Z80& proc, uint8_t b1)
     
     proc.a.write(temp8);
     
-    debug_print("ld a, %s\n", reg_name.c_str());
-    
     return cycles;
 }
 
@@ -671,8 +630,6 @@ inline uint8_t jr_cc_n(Z80& proc, uint8_t b1)
         cycles = 12;
         proc.pc.write(new_pc);
     }
-    
-    debug_print("jr %s, %d (0x%04x)\n", type.c_str(), offset, new_pc);
 
     return cycles;
 }
@@ -711,7 +668,6 @@ inline uint8_t rl_n(Z80& proc, uint8_t b1)
             uint8_t new_val = generic_rl_n(proc, proc.mem.read8(addr));
             proc.mem.write8(addr, new_val);
             
-            debug_print("%s", "rl (hl)\n");
             return 16;
         }
     }
@@ -719,7 +675,6 @@ inline uint8_t rl_n(Z80& proc, uint8_t b1)
     uint8_t new_val = generic_rl_n(proc, reg->read());
     reg->write(new_val);
     
-    debug_print("rl %s\n", reg->name);
     return 8;
 }
 
@@ -765,8 +720,6 @@ inline uint8_t bit_b_hl(Z80& proc, uint8_t b1)
     proc.f.set_n(false);
     proc.f.set_h(true);
     
-    debug_print("bit %d, (hl) (0x%04x, 0x%02x)\n", bit, addr, to_test);
-    
     return 12;
 }
 
@@ -1031,8 +984,6 @@ inline uint8_t bit_b_r(Z80& proc, uint8_t b1)
     proc.f.set_n(false);
     proc.f.set_h(true);
     
-    debug_print("bit %d, %s\n", bit, reg->name);
-    
     return cycles;
 }
 
@@ -1052,8 +1003,6 @@ inline uint8_t xor_n(Z80& proc, uint8_t b1)
     proc.f.set_h(false);
     proc.f.set_c(false);
     proc.a.write(arg.value);
-    
-    debug_print("%s\n", prt.c_str());
 
     return arg.cycles;
 }
@@ -1089,7 +1038,6 @@ inline uint8_t ld_nn_n(Z80& proc, uint8_t b1)
     
     reg->write(b2);
     
-    debug_print("ld %s, 0x%02x\n", reg->name, b2);
     return 8;
 }
 
@@ -1122,7 +1070,6 @@ inline uint8_t ld_n_nn(Z80& proc, uint8_t b1)
             throw std::runtime_error(formatted_string("Unknown byte 0x%02x for opcode ld_n_nn", b1));
     }
     
-    debug_print(fmt.c_str(), r.c_str(), imm);
     return 12;
 }
 
@@ -1132,8 +1079,6 @@ inline uint8_t ld_hl_dec_a(Z80& proc, uint8_t b1)
     uint16_t addr = proc.get_hl();
     proc.mem.write8(addr, temp8);
     
-    debug_print("ld (hl-), a (0x%04x, 0x%02x)\n", addr, temp8);
-    
     //Now decrement HL
     proc.set_hl(addr-1);
     return 8;
@@ -1141,7 +1086,6 @@ inline uint8_t ld_hl_dec_a(Z80& proc, uint8_t b1)
 
 inline uint8_t nop()
 {
-    debug_print("%s\n", "nop");
     return 4;
 }
 
@@ -1150,21 +1094,18 @@ inline uint8_t jp_nn(Z80& proc)
     uint16_t addr = proc.fetch_short();
     proc.pc.write(addr);
     
-    debug_print("jp 0x%04x\n", addr);
     return 12;
 }
 
 inline uint8_t di(Z80& proc)
 {
     proc.interrupt_enable = false;
-    debug_print("%s\n", "di");
     return 4;
 }
 
 inline uint8_t ei(Z80& proc)
 {
     proc.interrupt_enable = true;
-    debug_print("%s\n", "ei");
     return 4;
 }
 
@@ -1367,7 +1308,6 @@ inline uint8_t ld_r1_r2(Z80& proc, uint8_t b1)
             
             proc.mem.write8(addr, reg->read());
             
-            debug_print("ld (hl), %s\n", reg->name);
             return 8;
         }
          
@@ -1406,7 +1346,6 @@ inline uint8_t ld_r1_r2(Z80& proc, uint8_t b1)
             
             reg->write(value);
             
-            debug_print("ld %s, (hl)\n", reg->name);
             return 8;
         }
         //ld (hl), n
@@ -1416,7 +1355,6 @@ inline uint8_t ld_r1_r2(Z80& proc, uint8_t b1)
             uint8_t value = proc.fetch_byte();
             proc.mem.write8(addr, value);
             
-            debug_print("ld (hl), 0x%02x\n", value);
             return 12;
         }
         default:
@@ -1424,7 +1362,6 @@ inline uint8_t ld_r1_r2(Z80& proc, uint8_t b1)
     }
     
     lhs->write(rhs->read());
-    debug_print("ld %s, %s\n", lhs->name, rhs->name);
     
     return cycles;
 }
@@ -1435,7 +1372,6 @@ inline uint8_t ld_a_hl_plus(Z80& proc)
     proc.a.write(proc.mem.read8(addr));
     proc.set_hl(addr+1);
     
-    debug_print("%s", "ld a, (hl+)\n");
     return 8;
 }
 
@@ -1449,7 +1385,6 @@ inline uint8_t rst_n(Z80& proc, uint8_t b1)
     uint16_t offset = b1 & 0x38;
     proc.pc.write(offset);
     
-    debug_print("rst 0x%04x\n", offset);
     return 16;
 }
 
@@ -1465,7 +1400,6 @@ inline uint8_t and_n(Z80& proc, uint8_t b1)
     proc.f.set_h(true);
     proc.f.set_c(false);
     
-    debug_print("and %s\n", arg.name);
     return arg.cycles;
 }
 
@@ -1493,7 +1427,6 @@ inline uint8_t dec_nn(Z80& proc, uint8_t b1)
             break;
     }
     
-    debug_print("dec %s\n", reg.c_str());
     return 8;
 }
 
@@ -1509,7 +1442,6 @@ inline uint8_t or_n(Z80& proc, uint8_t b1)
     proc.f.set_h(false);
     proc.f.set_n(false);
     
-    debug_print("or %s\n", arg.name);
     return arg.cycles;
 }
 
@@ -1521,7 +1453,6 @@ inline uint8_t cpl(Z80& proc)
     proc.f.set_n(true);
     proc.f.set_h(true);
     
-    debug_print("%s\n", "cpl");
     return 4;
 }
 
@@ -1549,7 +1480,6 @@ inline uint8_t adc_a_n(Z80& proc, uint8_t b1)
     InstrArg arg = get_single_arg(proc, b1);
     generic_adc_a(proc, arg.value);
     
-    debug_print("adc a, %s\n", arg.name);
     return arg.cycles;
 }
 
@@ -1565,7 +1495,6 @@ inline uint8_t swap_n(Z80& proc, uint8_t b1)
     arg.write(new_value);
     proc.f.set_z(new_value==0);
     
-    debug_print("swap %s\n", reg->name);
     return 8;
 }
 
@@ -1604,7 +1533,6 @@ inline uint8_t add_hl_n(Z80& proc, uint8_t b1)
     //Carry from bit 15
     proc.f.set_c((uint32_t(original) + uint32_t(new_val)) > 0xffff);
     
-    debug_print("add hl, %s\n", pair.c_str());
     return 8;
 }
 
@@ -1612,7 +1540,6 @@ inline uint8_t jp_hl(Z80& proc)
 {
     proc.pc.write(proc.get_hl());
     
-    debug_print("%s\n", "jp (hl)");
     return 4;
 }
 
@@ -1622,7 +1549,6 @@ inline uint8_t res_b_n(Z80& proc, uint8_t b1)
     InstrArg arg = get_single_CB_arg(proc, b1);
     arg.write(arg.value & ~(1 << bit));
     
-    debug_print("res %d, %s\n", bit, arg.name);
     return 8;
 }
 
@@ -1637,7 +1563,6 @@ inline uint8_t jp_cc_nn(Z80& proc, uint8_t b1)
         proc.pc.write(jump_addr);
     }
     
-    debug_print("jp %s, 0x%02x\n", type.c_str(), jump_addr);
     return 12;
 }
 
@@ -1653,7 +1578,6 @@ inline uint8_t ret_cc(Z80& proc, uint8_t b1)
         proc.sp.inc(2);
     }
     
-    debug_print("ret %s\n", type.c_str());
     return 8;
 }
 
@@ -1669,7 +1593,6 @@ inline uint8_t sla_n(Z80& proc, uint8_t b1)
     
     arg.write(new_val);
     
-    debug_print("sla %s\n", reg->name);
     return 8;
 }
 
@@ -1687,7 +1610,6 @@ inline uint8_t call_cc_nn(Z80& proc, uint8_t b1)
         proc.pc.write(addr);
     }
     
-    debug_print("call %s, 0x%04x\n", type.c_str(), addr);
     return 12;
 }
 
@@ -1704,7 +1626,6 @@ inline uint8_t rlca(Z80& proc)
     proc.f.set_h(false);
     proc.f.set_c(a>>7);
     
-    debug_print("%s\n", "rlca");
     return 4;
 }
 
@@ -1726,7 +1647,6 @@ inline uint8_t add_sp_n(Z80& proc)
     
     //H and C?
     
-    debug_print("add sp, %d\n", offs);
     return 16;
 }
 
@@ -1750,7 +1670,6 @@ inline uint8_t rlc_n(Z80& proc, uint8_t b1)
     uint8_t new_value = generic_rlc(proc, arg.value);
     arg.write(new_value);
     
-    debug_print("rlc %s\n", arg.name);
     return 8;
 }
 
@@ -1761,7 +1680,6 @@ inline uint8_t reti(Z80& proc)
     proc.sp.inc(2);
     proc.interrupt_enable = true;
     
-    debug_print("%s\n", "reti");
     return 16;
 }
 
@@ -1780,7 +1698,6 @@ inline uint8_t sbc_a_n(Z80& proc, uint8_t b1)
     
     proc.a.write(new_value);
     
-    debug_print("sbc a, %s\n", arg.name);
     return arg.cycles;
 }
 
@@ -1789,7 +1706,6 @@ inline uint8_t ld_a_c(Z80& proc)
     uint16_t addr = 0xff00 + uint16_t(proc.c.read());
     proc.a.write(proc.mem.read8(addr));
     
-    debug_print("%s\n", "ld a, (c)");
     return 8;
 }
 
@@ -1799,7 +1715,6 @@ inline uint8_t scf(Z80& proc)
     proc.f.set_n(false);
     proc.f.set_h(false);
     
-    debug_print("%s\n", "scf");
     return 4;
 }
 
@@ -1808,14 +1723,12 @@ inline uint8_t ld_nn_sp(Z80& proc)
     uint16_t addr = proc.fetch_short();
     proc.mem.write16(addr, proc.sp.read());
     
-    debug_print("ld 0x%04x, sp\n", addr);
     return 20;
 }
 
 inline uint8_t ld_sp_hl(Z80& proc)
 {
     proc.sp.write(proc.get_hl());
-    debug_print("%s", "ld sp hl\n");
     return 8;
 }
 
@@ -1832,7 +1745,6 @@ inline uint8_t srl_n(Z80& proc, uint8_t b1)
     
     arg.write(new_value);
     
-    debug_print("srl %s\n", arg.name);
     return 8;
 }
 
@@ -1853,7 +1765,6 @@ inline uint8_t ldhl_sp_n(Z80& proc)
     
     proc.set_hl(new_hl);
     
-    debug_print("ldhl sp, 0x%02x\n", offs);
     return 12;
 }
 
@@ -1868,7 +1779,6 @@ inline uint8_t rcca(Z80& proc)
     //proc.f.set_z(a==0); //Not sure, unofficial manual says one thing, Z80 manual says preserved
     proc.a.write(a);
     
-    debug_print("rcca\n");
     return 4;
 }
 
@@ -1881,7 +1791,6 @@ inline uint8_t rra(Z80& proc)
     proc.f.set_h(false);
     proc.f.set_c(a & 1);
     
-    debug_print("rra\n");
     return 4;
 }
 
@@ -1892,7 +1801,6 @@ inline uint8_t ld_a_hl_minus(Z80& proc)
     proc.a.write(value);
     proc.set_hl(addr-1);
     
-    debug_print("ld a (hl-)\n");
     return 8;
 }
 
@@ -1901,7 +1809,6 @@ inline uint8_t stop(Z80& proc)
     proc.fetch_byte(); //2 byte opcode for some reason
     proc.stopped = true;
     
-    debug_print("%s\n", "stop");
     return 4;
 }
 
@@ -1918,7 +1825,6 @@ inline uint8_t rr_n(Z80& proc, uint8_t b1)
     
     arg.write(new_value);
     
-    debug_print("rr %s\n", arg.name);
     return 8;
 }
 
@@ -1946,7 +1852,6 @@ inline uint8_t daa(Z80& proc)
     proc.f.set_z(a==0);
     
     
-    debug_print("%s\n", "daa");
     return 4;
 }
 
@@ -1954,7 +1859,6 @@ inline uint8_t halt(Z80& proc)
 {
     proc.halted = true;
     
-    debug_print("halt\n");
     return 4;
 }
 
@@ -1964,7 +1868,6 @@ inline uint8_t set_b_r(Z80& proc, uint8_t b1)
     InstrArg arg = get_single_CB_arg(proc, b1);
     arg.write(arg.value | (1 << bit_no));
     
-    debug_print("set %d, %s\n", bit_no, arg.name);
     return 8;
 }
 
@@ -1974,7 +1877,6 @@ uint8_t ccf(Z80& proc)
     proc.f.set_n(false);
     proc.f.set_h(false);
     
-    debug_print("ccf\n");
     return 4;
 }
 
@@ -1990,7 +1892,6 @@ uint8_t rrc_n(Z80& proc, uint8_t b1)
     
     arg.write(res);
     
-    debug_print("rrc %s\n", arg.name);
     return 8;
 }
 
@@ -2012,7 +1913,6 @@ uint8_t sra_n(Z80& proc, uint8_t b1)
     
     arg.write(res);
     
-    debug_print("sra %s\n", arg.name);
     return 8;
 }
 
@@ -2076,17 +1976,25 @@ inline uint8_t cb_prefix_instr(Z80& proc)
 
 void Step(Z80& proc)
 {
-    uint8_t cycles = 0;
+    uint32_t cycles = 0;
+    
+#if GUEST_PROFILER
+    uint16_t profile_pc = proc.pc.read();
+    int profile_bank = proc.m_profiler ? proc.mem.rom_bank() : 0;
+#endif
     
     if (proc.halted)
     {
-        //printf("halted!\n");
-        //Need to send some cycles otherwise we won't fire interrupts to bring us back from halt
-        cycles = 8;
+        /*Only an interrupt brings us out of halt, so jump to the next thing
+         that could raise one. Kept to the 8 cycle steps we used to spin in
+         so that timing is the same as stepping there.*/
+        cycles = uint32_t(proc.mem.cycles_to_next_event());
+        cycles = std::max((cycles + 7) & ~7u, 8u);
     }
     else if (proc.stopped)
     {
-        printf("stopped!\n");
+        /*Only input brings us out of stop. Time doesn't pass, so the caller
+         should wait for input rather than stepping again straight away.*/
         if (proc.mem.m_input_handler.read_inputs())
         {
             proc.stopped = false;
@@ -2095,9 +2003,13 @@ void Step(Z80& proc)
     }
     else
     {
-        //Fetch first byte from PC
-        debug_print("PC: 0x%04x - ", proc.pc.read());
+        if (proc.m_trace)
+        {
+            proc.m_trace->begin(proc.m_total_cycles, proc.pc.read(), proc.get_af(),
+                                proc.get_bc(), proc.get_de(), proc.get_hl(), proc.sp.read());
+        }
         
+        //Fetch first byte from PC
         uint8_t b1 = proc.fetch_byte();
         
         switch (b1)
@@ -2477,6 +2389,13 @@ void Step(Z80& proc)
         }
     }
     
+#if GUEST_PROFILER
+    if (proc.m_profiler)
+    {
+        proc.m_profiler->record(profile_pc, profile_bank, cycles);
+    }
+#endif
+    
     //For future timing use/interrupt ei/di handling
     proc.tick(cycles);
 }
@@ -10,43 +10,98 @@
 #include "Z80.hpp"
 #include "instructions.hpp"
 #include "utils.hpp"
+#include "Profiler.hpp"
+#include "TraceBuffer.hpp"
+#include "FramePacer.hpp"
+#include "RingBuffer.hpp"
+#include "SDLApp.hpp"
+#include "InputLatency.hpp"
+#include "SocketLink.hpp"
+#include <memory>
+#include <fstream>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <algorithm>
 
-void screenshot_and_exit(Z80& proc, const std::string& rom_name)
+void screenshot_and_exit(SDLApp& display, const LCDFrame& frame, size_t cycles, const std::string& rom_name)
 {
     std::string file_name = rom_name;
     std::replace(file_name.begin(), file_name.end(), '.', '_');
     file_name += "_screenshot.bmp";
-    proc.mem.m_lcd_handler.SaveImage(file_name);
-    printf("Exiting and saving screenshot to %s after running for %zu cycles.\n", file_name.c_str(), proc.m_total_cycles);
+    display.SaveImage(file_name, frame);
+    printf("Exiting and saving screenshot to %s after running for %zu cycles.\n", file_name.c_str(), cycles);
 }
 
-class InputPollTimer
+std::string default_trace_path(const std::string& rom_name)
 {
-public:
-    InputPollTimer():
-        m_last_polled(SDL_GetTicks())
-    {}
-    
-    bool ShouldPoll()
+    std::string file_name = rom_name;
+    std::replace(file_name.begin(), file_name.end(), '.', '_');
+    return file_name + "_trace.bin";
+}
+
+void dump_trace(const TraceBuffer& trace, const std::string& path)
+{
+    trace.Dump(path);
+    printf("Wrote instruction trace to %s\n", path.c_str());
+}
+
+void print_serial_output(SerialOutput& output)
+{
+    std::string text = output.take_unprinted();
+    if (!text.empty())
     {
-        auto current = SDL_GetTicks();
-        if ((current - m_last_polled) >= (1000 / 60))
-        {
-            m_last_polled = current;
-            return true;
-        }
-        return false;
+        fwrite(text.data(), 1, text.size(), stdout);
+        fflush(stdout);
+    }
+}
+
+//Frames are only drawn if something is going to use them
+uint8_t next_frame_consumers(const emu_args& a, const Z80& proc, bool display, bool hashing)
+{
+    uint8_t consumers = 0;
+    if (display && !a.headless)
+    {
+        consumers |= FRAME_DISPLAY;
+    }
+    if (hashing)
+    {
+        consumers |= FRAME_HASH;
+    }
+    //The screenshot can be taken part way through a frame, so draw the one before it too
+    if ((a.num_cycles != 0) && ((proc.m_total_cycles + 2*LCD_CYCLES_PER_FRAME) >= a.num_cycles))
+    {
+        consumers |= FRAME_SCREENSHOT;
     }
+    return consumers;
+}
+
+//Sent from the main thread to the emulator thread
+struct CoreCommand
+{
+    enum Type { JOYPAD, TOGGLE_TURBO, TOGGLE_TRACE, DUMP_TRACE, SCREENSHOT, QUIT };
     
-private:
-    uint32_t m_last_polled;
+    Type type;
+    //Held buttons for JOYPAD
+    uint8_t value;
+    //From InputLatency::input_changed for JOYPAD
+    uint32_t sequence;
 };
 
 int main(int argc, const char * argv[]) {
     emu_args a = process_args(argc, argv);
     printf("%s", a.to_str().c_str());
     
-    MemoryMap map(a.rom_name, a.skip_boot, a.scale_factor);
+    if (a.headless)
+    {
+        //The window is still made for screenshots, just never shown
+        setenv("SDL_VIDEODRIVER", "dummy", 1);
+    }
+    
+    MemoryMap map(a.rom_name, a.skip_boot);
+    printf("%s\n", map.rom_info().c_str());
     Z80 proc(map);
     auto callback = [&proc](uint8_t num) { proc.post_interrupt(num); };
     map.set_int_callback(callback);
@@ -55,51 +110,373 @@ int main(int argc, const char * argv[]) {
     {
         proc.skip_bootstrap();
     }
+    
+    bool profiling = !a.profile_path.empty() || !a.profile_collapsed_path.empty();
+#if GUEST_PROFILER
+    std::unique_ptr<Profiler> profiler;
+    if (profiling)
+    {
+        profiler.reset(new Profiler(map.num_rom_banks()));
+        if (!a.sym_path.empty())
+        {
+            profiler->LoadSymbols(a.sym_path);
+        }
+        proc.m_profiler = profiler.get();
+    }
+#else
+    if (profiling)
+    {
+        throw std::runtime_error("Profiling requested but the profiler was compiled out. (GUEST_PROFILER)");
+    }
+#endif
 
-    SDL_Event event;
-    bool run = true;
-    InputPollTimer input_timer;
-    while(run)
+    //Allocated on first use, then kept so toggling doesn't lose history
+    std::unique_ptr<TraceBuffer> trace;
+    std::string trace_path = a.trace_path.empty() ? default_trace_path(a.rom_name) : a.trace_path;
+    if (!a.trace_path.empty())
+    {
+        trace.reset(new TraceBuffer());
+        proc.m_trace = trace.get();
+    }
+    
+    //Blocks until the other end has connected
+    std::unique_ptr<SocketLink> link;
+    if (!a.link_listen.empty())
+    {
+        link = SocketLink::listen_on(a.link_listen, a.link_window);
+    }
+    else if (!a.link_connect.empty())
+    {
+        link = SocketLink::connect_to(a.link_connect, a.link_window);
+    }
+    if (link)
+    {
+        map.connect_serial(link.get());
+    }
+    
+    //Test runs and runs without a window want to finish as soon as possible
+    SyncMode sync_mode = (a.num_cycles || a.test_result || a.headless) ? SYNC_NONE : SYNC_AUDIO;
+    if (!a.sync_mode.empty())
+    {
+        sync_mode = parse_sync_mode(a.sync_mode);
+    }
+    FramePacer pacer(sync_mode, map.m_sound_handler);
+    pacer.set_turbo(a.turbo);
+    size_t last_frame = map.m_lcd_handler.frame_count();
+    
+    std::ofstream frame_hashes;
+    if (!a.frame_hashes_path.empty())
+    {
+        frame_hashes.open(a.frame_hashes_path.c_str());
+        if (!frame_hashes.is_open())
+        {
+            throw std::runtime_error(formatted_string("Could not open %s for writing.", a.frame_hashes_path.c_str()));
+        }
+    }
+    bool hashing = frame_hashes.is_open();
+    
+    if (a.lcd_thread)
+    {
+        map.m_lcd_handler.start_render_thread();
+    }
+    map.m_lcd_handler.set_frame_consumers(next_frame_consumers(a, proc, true, hashing));
+    
+    SDLApp display(a.scale_factor, parse_scale_filter(a.filter));
+    display.Init();
+    
+    RingBuffer<CoreCommand> commands(64);
+    //Only used to wake the core when it is stopped, the queue itself doesn't lock
+    std::mutex command_mutex;
+    std::condition_variable command_sent;
+    auto send_command = [&](const CoreCommand& command)
+    {
+        bool sent = commands.push(&command, 1) == 1;
+        {
+            //Taken so the notify can't land between the core's check and its wait
+            std::lock_guard<std::mutex> lock(command_mutex);
+        }
+        command_sent.notify_one();
+        return sent;
+    };
+    auto send = [&](CoreCommand::Type type, uint8_t value)
+    {
+        CoreCommand command = {type, value, 0};
+        return send_command(command);
+    };
+    
+    InputLatency latency;
+    //With lateinput, the latest buttons are read from here at the first JOYP read of a frame
+    std::atomic<uint64_t> live_input(0);
+    if (a.late_input)
+    {
+        map.m_input_handler.set_live_input(&live_input);
+    }
+    
+    /*The emulator runs on its own thread so that presenting frames and
+     handling SDL events never hold it up. It doesn't call SDL at all,
+     frames come out through the LCD's triple buffer and input goes in
+     through the command queue.*/
+    std::atomic<bool> core_running(true);
+    bool take_screenshot = false;
+    std::exception_ptr core_error;
+    
+    std::thread core([&]()
+    {
+        //Returns false if the emulator should stop
+        auto handle_commands = [&]()
+        {
+            CoreCommand command;
+            while (commands.pop(&command, 1))
+            {
+                switch (command.type)
+                {
+                    case CoreCommand::JOYPAD:
+                        map.m_input_handler.set_buttons(command.value, command.sequence);
+                        break;
+                    case CoreCommand::TOGGLE_TURBO:
+                        pacer.set_turbo(!pacer.turbo());
+                        printf("Turbo %s\n", pacer.turbo() ? "on" : "off");
+                        break;
+                    case CoreCommand::TOGGLE_TRACE:
+                        if (!trace)
+                        {
+                            trace.reset(new TraceBuffer());
+                        }
+                        proc.m_trace = proc.m_trace ? nullptr : trace.get();
+                        printf("Instruction tracing %s\n", proc.m_trace ? "enabled" : "disabled");
+                        break;
+                    case CoreCommand::DUMP_TRACE:
+                        if (trace)
+                        {
+                            dump_trace(*trace, trace_path);
+                        }
+                        break;
+                    case CoreCommand::SCREENSHOT:
+                        take_screenshot = true;
+                        return false;
+                    case CoreCommand::QUIT:
+                        return false;
+                }
+            }
+            return true;
+        };
+        
+        try
+        {
+            bool run = true;
+            while(run)
+            {
+                try
+                {
+                    Step(proc);
+                }
+                catch (const std::exception&)
+                {
+                    //Keep the instructions that led up to the error
+                    if (trace)
+                    {
+                        dump_trace(*trace, trace_path);
+                    }
+                    throw;
+                }
+                
+                if (map.m_lcd_handler.frame_count() != last_frame)
+                {
+                    last_frame = map.m_lcd_handler.frame_count();
+                    if (hashing)
+                    {
+                        frame_hashes << formatted_string("%zu %016llx\n", last_frame,
+                                                         (unsigned long long)map.m_lcd_handler.frame_hash());
+                    }
+                    
+                    //Before handling commands, which would be the input for the next frame
+                    latency.frame_done(last_frame, map.m_input_handler.latched_sequence());
+                    map.m_input_handler.new_frame();
+                    
+                    //Test runs only print the result, so that many can run at once
+                    if (!a.test_result)
+                    {
+                        print_serial_output(map.serial_output());
+                    }
+                    
+                    bool shown = pacer.FrameDone();
+                    map.m_lcd_handler.set_frame_consumers(next_frame_consumers(a, proc, shown, hashing));
+                    run = handle_commands();
+                }
+                else if (proc.stopped)
+                {
+                    //No frames or time pass while stopped, so sleep until there's input
+                    {
+                        std::unique_lock<std::mutex> lock(command_mutex);
+                        command_sent.wait(lock, [&commands]() { return commands.size() != 0; });
+                    }
+                    run = handle_commands();
+                }
+                
+                if (a.test_result && (map.serial_output().result() != TEST_NONE))
+                {
+                    run = false;
+                }
+                
+                if ((a.num_cycles != 0) && (proc.m_total_cycles >= a.num_cycles))
+                {
+                    take_screenshot = true;
+                    run  = false;
+                }
+            }
+            
+            //So that the last frame is there for the screenshot
+            map.m_lcd_handler.finish_frames();
+        }
+        catch (...)
+        {
+            core_error = std::current_exception();
+        }
+        //So the other end doesn't wait for us
+        if (link)
+        {
+            link->disconnect();
+        }
+        core_running = false;
+    });
+    
+    //Commands are only dropped if the queue is full, in which case the core has stopped
+    uint8_t live_buttons = 0;
+    uint8_t sent_buttons = 0;
+    uint32_t sequence = 0;
+    while (core_running)
     {
-        if (input_timer.ShouldPoll())
+        SDL_Event event;
+        while (SDL_PollEvent(&event))
         {
-            SDL_PollEvent(&event);
             switch (event.type)
             {
                 case SDL_QUIT:
-                    run = false;
+                    send(CoreCommand::QUIT, 0);
                     break;
                 case SDL_KEYDOWN:
                 {
-                    const uint8_t *state = SDL_GetKeyboardState(NULL);
-                    if (state[SDL_SCANCODE_S])
+                    if (event.key.repeat)
                     {
-                        screenshot_and_exit(proc, a.rom_name);
-                        run = false;
                         break;
                     }
-                    else if (state[SDL_SCANCODE_ESCAPE])
+                    
+                    switch (event.key.keysym.scancode)
                     {
-                        run = false;
-                        break;
+                        case SDL_SCANCODE_S:
+                            send(CoreCommand::SCREENSHOT, 0);
+                            break;
+                        case SDL_SCANCODE_ESCAPE:
+                            send(CoreCommand::QUIT, 0);
+                            break;
+                        case SDL_SCANCODE_TAB:
+                            send(CoreCommand::TOGGLE_TURBO, 0);
+                            break;
+                        case SDL_SCANCODE_T:
+                            send(CoreCommand::TOGGLE_TRACE, 0);
+                            break;
+                        case SDL_SCANCODE_D:
+                            send(CoreCommand::DUMP_TRACE, 0);
+                            break;
+                        default:
+                            break;
                     }
+                    break;
                 }
             }
         }
         
-        Step(proc);
+        uint8_t buttons = InputManager::buttons_from_keyboard();
+        if (buttons != live_buttons)
+        {
+            live_buttons = buttons;
+            sequence = latency.input_changed();
+            live_input.store(InputManager::make_live_input(buttons, sequence), std::memory_order_release);
+        }
         
-        if ((a.num_cycles != 0) && (proc.m_total_cycles >= a.num_cycles))
+        //Also wakes the core from STOP, so sent even with lateinput
+        if (live_buttons != sent_buttons)
         {
-            screenshot_and_exit(proc, a.rom_name);
-            run  = false;
+            CoreCommand command = {CoreCommand::JOYPAD, live_buttons, sequence};
+            if (send_command(command))
+            {
+                sent_buttons = live_buttons;
+            }
         }
         
-        if (proc.pc.read() == 0x256f)
+        if (map.m_lcd_handler.m_frames.update())
+        {
+            display.Present(map.m_lcd_handler.m_frames.front().frame);
+            latency.presented(map.m_lcd_handler.m_frames.front().number);
+        }
+        else
+        {
+            SDL_Delay(1);
+        }
+    }
+    core.join();
+    
+    if (core_error)
+    {
+        std::rethrow_exception(core_error);
+    }
+    
+    if (take_screenshot)
+    {
+        //Make sure the last frame is on screen
+        map.m_lcd_handler.m_frames.update();
+        display.Present(map.m_lcd_handler.m_frames.front().frame);
+        screenshot_and_exit(display, map.m_lcd_handler.m_frames.front().frame, proc.m_total_cycles, a.rom_name);
+    }
+    
+    if (!a.test_result)
+    {
+        print_serial_output(map.serial_output());
+    }
+    
+    RenderStats stats = map.m_lcd_handler.render_stats();
+    printf("Drew %zu scanlines, reused %zu unchanged from the last frame.\n", stats.lines_drawn, stats.lines_reused);
+    
+    LatencyStats input_stats = latency.stats();
+    if (input_stats.count)
+    {
+        printf("Input took %.1fms on average to reach the screen, %.1fms at worst. (%zu changes)\n",
+               input_stats.average_ms, input_stats.worst_ms, input_stats.count);
+    }
+    
+    if (trace && !a.trace_path.empty())
+    {
+        dump_trace(*trace, trace_path);
+    }
+    
+#if GUEST_PROFILER
+    if (profiler)
+    {
+        if (!a.profile_path.empty())
+        {
+            profiler->WriteReport(a.profile_path);
+        }
+        if (!a.profile_collapsed_path.empty())
+        {
+            profiler->WriteCollapsed(a.profile_collapsed_path);
+        }
+    }
+#endif
+    
+    if (a.test_result)
+    {
+        switch (map.serial_output().result())
         {
-            //return 0;
-            uint8_t foo = 1;
-            (void)foo;
+            case TEST_PASSED:
+                printf("Passed after %zu cycles.\n", proc.m_total_cycles);
+                return 0;
+            case TEST_FAILED:
+                printf("Failed after %zu cycles. Serial output was:\n%s\n",
+                       proc.m_total_cycles, map.serial_output().text().c_str());
+                return 1;
+            case TEST_NONE:
+                printf("No test result after %zu cycles.\n", proc.m_total_cycles);
+                return 1;
         }
     }
     
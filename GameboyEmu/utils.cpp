@@ -7,6 +7,7 @@
 //
 
 #include "utils.hpp"
+#include <stdexcept>
 
 namespace
 {
@@ -29,6 +30,55 @@ emu_args process_args(int argc, const char* argv[])
             a.skip_boot = true;
         }
         
+        if (find_arg("turbo", arg))
+        {
+            a.turbo = true;
+        }
+        
+        if (find_arg("headless", arg))
+        {
+            a.headless = true;
+        }
+        
+        if (find_arg("lcdthread", arg))
+        {
+            a.lcd_thread = true;
+        }
+        
+        if (find_arg("lateinput", arg))
+        {
+            a.late_input = true;
+        }
+        
+        if (find_arg("testresult", arg))
+        {
+            a.test_result = true;
+        }
+        
+        std::string frame_hashes_arg = "--framehashes=";
+        if (find_arg(frame_hashes_arg, arg))
+        {
+            a.frame_hashes_path = arg.substr(frame_hashes_arg.size(), std::string::npos);
+        }
+        
+        std::string link_listen_arg = "--linklisten=";
+        if (find_arg(link_listen_arg, arg))
+        {
+            a.link_listen = arg.substr(link_listen_arg.size(), std::string::npos);
+        }
+        
+        std::string link_connect_arg = "--linkconnect=";
+        if (find_arg(link_connect_arg, arg))
+        {
+            a.link_connect = arg.substr(link_connect_arg.size(), std::string::npos);
+        }
+        
+        std::string link_window_arg = "--linkwindow=";
+        if (find_arg(link_window_arg, arg))
+        {
+            a.link_window = std::stol(arg.substr(link_window_arg.size(), std::string::npos), NULL, 10);
+        }
+        
         std::string scale_factor = "--scale=";
         if (find_arg(scale_factor, arg))
         {
@@ -41,6 +91,42 @@ emu_args process_args(int argc, const char* argv[])
             a.num_cycles = std::stol(arg.substr(num_cycles_arg.size(), std::string::npos), NULL, 10);
         }
         
+        std::string profile_arg = "--profile=";
+        if (find_arg(profile_arg, arg))
+        {
+            a.profile_path = arg.substr(profile_arg.size(), std::string::npos);
+        }
+        
+        std::string collapsed_arg = "--profilecollapsed=";
+        if (find_arg(collapsed_arg, arg))
+        {
+            a.profile_collapsed_path = arg.substr(collapsed_arg.size(), std::string::npos);
+        }
+        
+        std::string sym_arg = "--sym=";
+        if (find_arg(sym_arg, arg))
+        {
+            a.sym_path = arg.substr(sym_arg.size(), std::string::npos);
+        }
+        
+        std::string trace_arg = "--trace=";
+        if (find_arg(trace_arg, arg))
+        {
+            a.trace_path = arg.substr(trace_arg.size(), std::string::npos);
+        }
+        
+        std::string sync_arg = "--sync=";
+        if (find_arg(sync_arg, arg))
+        {
+            a.sync_mode = arg.substr(sync_arg.size(), std::string::npos);
+        }
+        
+        std::string filter_arg = "--filter=";
+        if (find_arg(filter_arg, arg))
+        {
+            a.filter = arg.substr(filter_arg.size(), std::string::npos);
+        }
+        
         std::string rom_arg = "--rom=";
         if (find_arg(rom_arg, arg))
         {
@@ -53,5 +139,10 @@ emu_args process_args(int argc, const char* argv[])
         throw std::runtime_error("Rom name is required. (--rom=<path>)");
     }
     
+    if (!a.link_listen.empty() && !a.link_connect.empty())
+    {
+        throw std::runtime_error("Only one of --linklisten and --linkconnect can be used.");
+    }
+    
     return a;
 }
@@ -17,6 +17,16 @@ void init_array(T& container)
     std::fill(container.begin(), container.end(), typename T::value_type());
 }
 
+//Hint that addr will be read soon, no effect on compilers without a builtin for it
+inline void prefetch(const void* addr)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_prefetch(addr);
+#else
+    (void)addr;
+#endif
+}
+
 //For reasons unknown to me, if this is in a cpp file, the linker complains.
 template< typename... Args >
 std::string formatted_string(const char* format, Args... args)
@@ -43,7 +53,22 @@ struct emu_args
     skip_boot(false),
     scale_factor(1),
     rom_name(""),
-    num_cycles(0)
+    num_cycles(0),
+    profile_path(""),
+    profile_collapsed_path(""),
+    sym_path(""),
+    trace_path(""),
+    sync_mode(""),
+    filter("nearest"),
+    turbo(false),
+    headless(false),
+    lcd_thread(false),
+    late_input(false),
+    test_result(false),
+    frame_hashes_path(""),
+    link_listen(""),
+    link_connect(""),
+    link_window(70224)
     {}
     
     std::string to_str()
@@ -60,6 +85,22 @@ struct emu_args
     int scale_factor;
     std::string rom_name;
     size_t num_cycles;
+    std::string profile_path;
+    std::string profile_collapsed_path;
+    std::string sym_path;
+    std::string trace_path;
+    std::string sync_mode;
+    std::string filter;
+    bool turbo;
+    bool headless;
+    bool lcd_thread;
+    bool late_input;
+    bool test_result;
+    std::string frame_hashes_path;
+    std::string link_listen;
+    std::string link_connect;
+    //Clocks, one frame by default
+    size_t link_window;
 };
 
 emu_args process_args(int argc, const char* argv[]);
@@ -0,0 +1,252 @@
+//
+//  Benchmark.cpp
+//  GameboyEmuBench
+//
+//  Created by David Spickett on 18/10/2026.
+//  Copyright © 2026 David Spickett. All rights reserved.
+//
+
+#include "Benchmark.hpp"
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <regex>
+#include <algorithm>
+#include <stdexcept>
+#include "utils.hpp"
+
+namespace
+{
+    bool find_arg(std::string name, std::string arg)
+    {
+        return arg.find(name) != std::string::npos;
+    }
+    
+    std::string arg_value(std::string name, std::string arg)
+    {
+        return arg.substr(name.size(), std::string::npos);
+    }
+    
+    double seconds_since(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+    }
+}
+
+bench_args process_bench_args(int argc, const char* argv[])
+{
+    bench_args a;
+    
+    for (auto i=1; i<argc; ++i)
+    {
+        std::string arg(argv[i]);
+        
+        std::string json_arg = "--json=";
+        if (find_arg(json_arg, arg))
+        {
+            a.json_path = arg_value(json_arg, arg);
+        }
+        
+        std::string baseline_arg = "--baseline=";
+        if (find_arg(baseline_arg, arg))
+        {
+            a.baseline_path = arg_value(baseline_arg, arg);
+        }
+        
+        std::string filter_arg = "--filter=";
+        if (find_arg(filter_arg, arg))
+        {
+            a.filter = arg_value(filter_arg, arg);
+        }
+        
+        std::string rom_dir_arg = "--romdir=";
+        if (find_arg(rom_dir_arg, arg))
+        {
+            a.rom_dir = arg_value(rom_dir_arg, arg);
+        }
+        
+        std::string write_roms_arg = "--writeroms=";
+        if (find_arg(write_roms_arg, arg))
+        {
+            a.write_roms_dir = arg_value(write_roms_arg, arg);
+        }
+        
+        std::string min_time_arg = "--mintime=";
+        if (find_arg(min_time_arg, arg))
+        {
+            a.min_time = std::stod(arg_value(min_time_arg, arg));
+        }
+        
+        std::string reps_arg = "--repetitions=";
+        if (find_arg(reps_arg, arg))
+        {
+            a.repetitions = std::stoi(arg_value(reps_arg, arg), NULL, 10);
+        }
+        
+        std::string threshold_arg = "--threshold=";
+        if (find_arg(threshold_arg, arg))
+        {
+            a.threshold = std::stod(arg_value(threshold_arg, arg));
+        }
+        
+        std::string frames_arg = "--frames=";
+        if (find_arg(frames_arg, arg))
+        {
+            a.macro_frames = std::stol(arg_value(frames_arg, arg), NULL, 10);
+        }
+    }
+    
+    if (a.repetitions < 1)
+    {
+        throw std::runtime_error("Repetitions must be at least 1.");
+    }
+    
+    return a;
+}
+
+bool BenchmarkRunner::wanted(const std::string& name) const
+{
+    return m_args.filter.empty() || find_arg(m_args.filter, name);
+}
+
+void BenchmarkRunner::Time(const std::string& name, BenchFn fn)
+{
+    if (!wanted(name))
+    {
+        return;
+    }
+    
+    double best_ns = 0;
+    for (auto rep=0; rep<m_args.repetitions; ++rep)
+    {
+        //Double the batch until it runs long enough to be worth timing
+        size_t ops = 1;
+        double elapsed = 0;
+        while (true)
+        {
+            auto start = std::chrono::steady_clock::now();
+            fn(ops);
+            elapsed = seconds_since(start);
+            
+            if ((elapsed >= m_args.min_time) || (ops >= (size_t(1) << 40)))
+            {
+                break;
+            }
+            ops *= 2;
+        }
+        
+        double ns = (elapsed*1e9) / ops;
+        if ((rep == 0) || (ns < best_ns))
+        {
+            best_ns = ns;
+        }
+    }
+    
+    Report(name, best_ns, "ns/op", false);
+}
+
+void BenchmarkRunner::Report(const std::string& name, double value, const std::string& unit, bool higher_is_better)
+{
+    if (!wanted(name))
+    {
+        return;
+    }
+    
+    printf("%-40s %14.3f %s\n", name.c_str(), value, unit.c_str());
+    fflush(stdout);
+    
+    BenchResult r;
+    r.name = name;
+    r.value = value;
+    r.unit = unit;
+    r.higher_is_better = higher_is_better;
+    m_results.push_back(r);
+}
+
+void WriteJSON(const BenchResults& results, const std::string& path)
+{
+    std::ofstream out(path.c_str());
+    if (!out.is_open())
+    {
+        throw std::runtime_error(formatted_string("Could not open %s for writing.", path.c_str()));
+    }
+    
+    out << "{\n    \"benchmarks\": [\n";
+    for (auto it=results.cbegin(); it != results.cend(); ++it)
+    {
+        out << formatted_string(
+            "        {\"name\": \"%s\", \"value\": %.6f, \"unit\": \"%s\", \"higher_is_better\": %s}",
+            it->name.c_str(), it->value, it->unit.c_str(),
+            it->higher_is_better ? "true" : "false");
+        out << ((it+1) != results.cend() ? ",\n" : "\n");
+    }
+    out << "    ]\n}\n";
+}
+
+BenchResults ReadJSON(const std::string& path)
+{
+    std::ifstream in(path.c_str());
+    if (!in.is_open())
+    {
+        throw std::runtime_error(formatted_string("File %s does not exist.", path.c_str()));
+    }
+    std::stringstream buf;
+    buf << in.rdbuf();
+    std::string json = buf.str();
+    
+    //Only needs to read back what WriteJSON writes, one flat object per result
+    const std::regex object_re("\\{[^{}]*\\}");
+    const std::regex name_re("\"name\"\\s*:\\s*\"([^\"]*)\"");
+    const std::regex value_re("\"value\"\\s*:\\s*([-+0-9.eE]+)");
+    const std::regex unit_re("\"unit\"\\s*:\\s*\"([^\"]*)\"");
+    const std::regex higher_re("\"higher_is_better\"\\s*:\\s*(true|false)");
+    
+    BenchResults results;
+    for (std::sregex_iterator it(json.begin(), json.end(), object_re), end; it != end; ++it)
+    {
+        std::string obj = it->str();
+        std::smatch name, value, unit, higher;
+        if (std::regex_search(obj, name, name_re) && std::regex_search(obj, value, value_re))
+        {
+            BenchResult r;
+            r.name = name[1];
+            r.value = std::stod(value[1]);
+            r.unit = std::regex_search(obj, unit, unit_re) ? std::string(unit[1]) : "";
+            r.higher_is_better = std::regex_search(obj, higher, higher_re) && (higher[1] == "true");
+            results.push_back(r);
+        }
+    }
+    
+    return results;
+}
+
+int CompareToBaseline(const BenchResults& results, const BenchResults& baseline, double threshold)
+{
+    int regressions = 0;
+    printf("\n%-40s %14s %14s %9s\n", "Benchmark", "Baseline", "Current", "Change");
+    
+    for (auto& r : results)
+    {
+        auto base = std::find_if(baseline.cbegin(), baseline.cend(),
+                                 [&r](const BenchResult& b) { return b.name == r.name; });
+        if ((base == baseline.cend()) || (base->value == 0))
+        {
+            printf("%-40s %14s %14.3f %9s\n", r.name.c_str(), "-", r.value, "new");
+            continue;
+        }
+        
+        double change = ((r.value - base->value) / base->value) * 100.0;
+        //Positive is always worse, whichever way the metric goes
+        double worse_by = r.higher_is_better ? -change : change;
+        bool regressed = worse_by > threshold;
+        if (regressed)
+        {
+            ++regressions;
+        }
+        
+        printf("%-40s %14.3f %14.3f %+8.1f%%%s\n", r.name.c_str(), base->value, r.value,
+               change, regressed ? " REGRESSION" : "");
+    }
+    
+    return regressions;
+}
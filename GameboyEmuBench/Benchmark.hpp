@@ -0,0 +1,85 @@
+//
+//  Benchmark.hpp
+//  GameboyEmuBench
+//
+//  Created by David Spickett on 18/10/2026.
+//  Copyright © 2026 David Spickett. All rights reserved.
+//
+
+#ifndef Benchmark_hpp
+#define Benchmark_hpp
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <functional>
+
+struct bench_args
+{
+    bench_args():
+        json_path(""),
+        baseline_path(""),
+        filter(""),
+        rom_dir("/tmp"),
+        write_roms_dir(""),
+        min_time(0.2),
+        repetitions(3),
+        threshold(10.0),
+        macro_frames(120)
+    {}
+    
+    std::string json_path;
+    std::string baseline_path;
+    std::string filter;
+    std::string rom_dir;
+    std::string write_roms_dir;
+    double min_time;
+    int repetitions;
+    double threshold;
+    size_t macro_frames;
+};
+
+bench_args process_bench_args(int argc, const char* argv[]);
+
+struct BenchResult
+{
+    std::string name;
+    double value;
+    std::string unit;
+    bool higher_is_better;
+};
+
+using BenchResults = std::vector<BenchResult>;
+
+//Runs a batch of the given number of operations
+using BenchFn = std::function<void(size_t)>;
+
+class BenchmarkRunner
+{
+public:
+    explicit BenchmarkRunner(const bench_args& args):
+        m_args(args)
+    {}
+    
+    bool wanted(const std::string& name) const;
+    
+    //Repeatedly time fn with growing batch sizes and record the best ns/op
+    void Time(const std::string& name, BenchFn fn);
+    //Record a value measured by the benchmark itself, e.g. MIPS
+    void Report(const std::string& name, double value, const std::string& unit, bool higher_is_better);
+    
+    const BenchResults& results() const { return m_results; }
+    const bench_args& args() const { return m_args; }
+    
+private:
+    bench_args m_args;
+    BenchResults m_results;
+};
+
+void WriteJSON(const BenchResults& results, const std::string& path);
+BenchResults ReadJSON(const std::string& path);
+
+//Returns the number of results that regressed by more than threshold percent
+int CompareToBaseline(const BenchResults& results, const BenchResults& baseline, double threshold);
+
+#endif /* Benchmark_hpp */
@@ -0,0 +1,216 @@
+//
+//  Benchmarks.cpp
+//  GameboyEmuBench
+//
+//  Created by David Spickett on 18/10/2026.
+//  Copyright © 2026 David Spickett. All rights reserved.
+//
+
+#include "Benchmarks.hpp"
+#include <memory>
+#include <algorithm>
+
+namespace
+{
+    std::string save_rom(RomBuilder& rom, const std::string& name, const bench_args& args)
+    {
+        std::string path = args.rom_dir + "/gbbench_" + name + ".gb";
+        std::replace(path.begin()+args.rom_dir.size(), path.end(), '/', '_');
+        rom.Save(path);
+        return path;
+    }
+    
+    //Opcodes repeated in a loop, to time Step() on one class of instruction
+    struct OpcodeClass
+    {
+        std::string name;
+        std::vector<uint8_t> setup;
+        std::vector<uint8_t> body;
+    };
+    
+    const uint16_t SUBROUTINE_ADDR = 0x3000;
+    const int BODY_REPEATS = 32;
+    
+    //ld hl, 0xc000 so (hl) accesses go to work RAM
+    const std::vector<uint8_t> HL_TO_WRAM = {0x21, 0x00, 0xc0};
+    
+    const std::vector<OpcodeClass> OPCODE_CLASSES = {
+        {"nop",         {},          {0x00}},
+        {"ld_r_r",      {},          {0x41}},             //ld b, c
+        {"ld_r_n",      {},          {0x06, 0x12}},       //ld b, 0x12
+        {"alu_r",       {},          {0x80}},             //add a, b
+        {"alu_n",       {},          {0xc6, 0x01}},       //add a, 0x01
+        {"alu_hl",      HL_TO_WRAM,  {0x86}},             //add a, (hl)
+        {"ld_hl_store", HL_TO_WRAM,  {0x77}},             //ld (hl), a
+        {"ld_hl_load",  HL_TO_WRAM,  {0x7e}},             //ld a, (hl)
+        {"inc_r",       {},          {0x04}},             //inc b
+        {"inc_rr",      {},          {0x03}},             //inc bc
+        {"jr",          {},          {0x18, 0x00}},       //jr +0
+        {"call_ret",    {},          {0xcd, uint8_t(SUBROUTINE_ADDR), uint8_t(SUBROUTINE_ADDR >> 8)}},
+        {"push_pop",    {},          {0xc5, 0xc1}},       //push bc, pop bc
+        {"cb_bit",      {},          {0xcb, 0x7c}},       //bit 7, h
+        {"cb_rotate",   {},          {0xcb, 0x11}},       //rl c
+        {"ldh_hram",    {},          {0xe0, 0x80}},       //ldh (0x80), a
+        {"ldh_io",      {},          {0xf0, 0x44}},       //ldh a, (LY)
+    };
+    
+    RomBuilder opcode_class_rom(const OpcodeClass& oc)
+    {
+        RomBuilder rom("OPCODES");
+        for (auto b : oc.setup)
+        {
+            rom.emit(b);
+        }
+        
+        uint16_t loop = rom.here();
+        for (auto i=0; i<BODY_REPEATS; ++i)
+        {
+            for (auto b : oc.body)
+            {
+                rom.emit(b);
+            }
+        }
+        //jp loop
+        rom.emit(0xc3);
+        rom.emit16(loop);
+        
+        //Callee for call_ret, just returns
+        rom.seek(SUBROUTINE_ADDR);
+        rom.emit(0xc9);
+        
+        return rom;
+    }
+    
+    struct MemoryRegion
+    {
+        std::string name;
+        uint16_t start;
+        //Accesses are spread over start to start+mask
+        uint16_t mask;
+        uint8_t value;
+    };
+    
+    const std::vector<MemoryRegion> READ_REGIONS = {
+        {"rom0",       0x0150, 0xff, 0},
+        {"romx",       0x4000, 0xff, 0},
+        {"vram_tiles", 0x8000, 0xff, 0},
+        {"vram_map",   0x9800, 0xff, 0},
+        {"cart_ram",   0xa000, 0xff, 0},
+        {"wram",       0xc000, 0xff, 0},
+        {"echo_ram",   0xe000, 0xff, 0},
+        {"joypad",     0xff00, 0x00, 0},
+        {"timer",      0xff04, 0x03, 0},
+        {"sound",      0xff10, 0x0f, 0},
+        {"lcd_ly",     0xff44, 0x00, 0},
+        {"hram",       0xff80, 0x3f, 0},
+    };
+    
+    //Note that LCDC and DMA writes are left out, they aren't simple stores
+    const std::vector<MemoryRegion> WRITE_REGIONS = {
+        {"rom_bank_select", 0x2000, 0xff, 1},
+        {"vram_tiles",      0x8000, 0xff, 0x55},
+        {"vram_map",        0x9800, 0xff, 0x01},
+        {"oam",             0xfe00, 0x9f, 0x10},
+        {"wram",            0xc000, 0xff, 0x55},
+        {"echo_ram",        0xe000, 0xff, 0x55},
+        {"timer",           0xff05, 0x00, 0x00},
+        {"sound",           0xff10, 0x0f, 0x00},
+        {"lcd_scroll",      0xff43, 0x00, 0x00},
+        {"hram",            0xff80, 0x3f, 0x55},
+    };
+}
+
+BenchInstance::BenchInstance(RomBuilder rom, const std::string& name, const bench_args& args):
+    rom_path(save_rom(rom, name, args)),
+    map(rom_path, true),
+    proc(map),
+    frames(0)
+{
+    auto callback = [this](uint8_t num)
+    {
+        if (num == LCD_VBLANK)
+        {
+            ++frames;
+        }
+        proc.post_interrupt(num);
+    };
+    map.set_int_callback(callback);
+    proc.skip_bootstrap();
+}
+
+size_t BenchInstance::RunFrames(size_t num_frames)
+{
+    size_t steps = 0;
+    size_t target = frames + num_frames;
+    while (frames < target)
+    {
+        Step(proc);
+        ++steps;
+    }
+    return steps;
+}
+
+void RegisterCPUBenchmarks(BenchmarkRunner& runner)
+{
+    for (auto& oc : OPCODE_CLASSES)
+    {
+        std::string name = "step/" + oc.name;
+        if (!runner.wanted(name))
+        {
+            continue;
+        }
+        
+        std::unique_ptr<BenchInstance> inst(new BenchInstance(opcode_class_rom(oc), name, runner.args()));
+        Z80& proc = inst->proc;
+        runner.Time(name, [&proc](size_t ops)
+        {
+            for (size_t i=0; i<ops; ++i)
+            {
+                Step(proc);
+            }
+        });
+    }
+}
+
+void RegisterMemoryBenchmarks(BenchmarkRunner& runner)
+{
+    std::unique_ptr<BenchInstance> inst(new BenchInstance(RomBuilder("MEMORY"), "memory", runner.args()));
+    MemoryMap& map = inst->map;
+    
+    for (auto& region : READ_REGIONS)
+    {
+        runner.Time("read8/" + region.name, [&map, region](size_t ops)
+        {
+            volatile uint8_t sink = 0;
+            for (size_t i=0; i<ops; ++i)
+            {
+                sink = map.read8(region.start + (i & region.mask));
+            }
+            (void)sink;
+        });
+    }
+    
+    for (auto& region : WRITE_REGIONS)
+    {
+        runner.Time("write8/" + region.name, [&map, region](size_t ops)
+        {
+            for (size_t i=0; i<ops; ++i)
+            {
+                map.write8(region.start + (i & region.mask), region.value);
+            }
+        });
+    }
+    
+    //Changes a byte each time so that the copy isn't skipped as unchanged
+    size_t cycles = 0;
+    runner.Time("dma/oam_from_wram", [&map, &cycles](size_t ops)
+    {
+        for (size_t i=0; i<ops; ++i)
+        {
+            map.write8(GB_RAM_START, uint8_t(i));
+            map.write8(0xff46, GB_RAM_START >> 8);
+            cycles += 640;
+            map.tick(cycles);
+        }
+    });
+}
@@ -0,0 +1,40 @@
+//
+//  Benchmarks.hpp
+//  GameboyEmuBench
+//
+//  Created by David Spickett on 18/10/2026.
+//  Copyright © 2026 David Spickett. All rights reserved.
+//
+
+#ifndef Benchmarks_hpp
+#define Benchmarks_hpp
+
+#include "Benchmark.hpp"
+#include "RomBuilder.hpp"
+#include "Z80.hpp"
+#include "instructions.hpp"
+
+//An emulator running a synthetic ROM, bootstrap skipped.
+struct BenchInstance
+{
+    BenchInstance(RomBuilder rom, const std::string& name, const bench_args& args);
+    
+    //Step until the given number of frames have been completed
+    size_t RunFrames(size_t frames);
+    
+    std::string rom_path;
+    MemoryMap map;
+    Z80 proc;
+    //Counted from VBLANK interrupts
+    size_t frames;
+};
+
+void RegisterCPUBenchmarks(BenchmarkRunner& runner);
+void RegisterMemoryBenchmarks(BenchmarkRunner& runner);
+void RegisterLCDBenchmarks(BenchmarkRunner& runner);
+void RegisterMacroBenchmarks(BenchmarkRunner& runner);
+void RegisterMultiBenchmarks(BenchmarkRunner& runner);
+void RegisterLinkBenchmarks(BenchmarkRunner& runner);
+void RegisterUpscaleBenchmarks(BenchmarkRunner& runner);
+
+#endif /* Benchmarks_hpp */
@@ -0,0 +1,178 @@
+//
+//  LCDBenchmarks.cpp
+//  GameboyEmuBench
+//
+//  Created by David Spickett on 18/10/2026.
+//  Copyright © 2026 David Spickett. All rights reserved.
+//
+
+#include "Benchmarks.hpp"
+#include <memory>
+#include <vector>
+
+namespace
+{
+    const uint16_t LCDCONTROL = 0xff40;
+    const uint16_t LCDSTAT    = 0xff41;
+    const uint16_t CURLINE    = 0xff44;
+    const uint16_t BGRDPAL    = 0xff47;
+    const uint16_t OBJPAL0    = 0xff48;
+    const uint16_t WINPOSY    = 0xff4a;
+    const uint16_t WINPOSX    = 0xff4b;
+    
+    const int SPRITES_ON_LINE = 10;
+    
+    struct ModeName
+    {
+        uint8_t mode;
+        std::string name;
+    };
+    
+    const std::vector<ModeName> LCD_MODES = {
+        {0, "hblank"},
+        {1, "vblank"},
+        {2, "oam_access"},
+        {3, "both_access"},
+    };
+    
+    /*Fill VRAM with varied tiles, put the window over the right half of the
+     screen and SPRITES_ON_LINE sprites on scanline 0.*/
+    void setup_scene(MemoryMap& map)
+    {
+        for (uint16_t addr=LCD_MEM_START; addr<LCD_BGRND_DATA; ++addr)
+        {
+            map.write8(addr, uint8_t(addr * 37));
+        }
+        for (uint16_t addr=LCD_BGRND_DATA; addr<LCD_MEM_END; ++addr)
+        {
+            map.write8(addr, uint8_t(addr));
+        }
+        
+        for (auto i=0; i<SPRITES_ON_LINE; ++i)
+        {
+            uint16_t addr = LCD_OAM_START + (i*SPRITE_INFO_BYTES);
+            map.write8(addr,   16);        //Y, top of the screen
+            map.write8(addr+1, 8 + i*16);  //X
+            map.write8(addr+2, i);         //Tile
+            map.write8(addr+3, 0);         //Flags
+        }
+        
+        map.write8(BGRDPAL, 0xe4);
+        map.write8(OBJPAL0, 0xe4);
+        map.write8(WINPOSY, 0);
+        map.write8(WINPOSX, 7 + (LCD_WIDTH/2));
+        //LCD on, window on using 0x9c00, unsigned tiles, background and sprites on
+        map.write8(LCDCONTROL, 0xf3);
+        //Back to scanline 0
+        map.write8(CURLINE, 0);
+    }
+}
+
+void RegisterLCDBenchmarks(BenchmarkRunner& runner)
+{
+    std::unique_ptr<BenchInstance> inst(new BenchInstance(RomBuilder("LCD"), "lcd", runner.args()));
+    MemoryMap& map = inst->map;
+    LCD& lcd = map.m_lcd_handler;
+    setup_scene(map);
+    
+    LCDRenderer& renderer = lcd.m_renderer;
+    renderer.set_line(0, lcd.registers());
+    runner.Time("lcd/draw_background", [&renderer](size_t ops)
+    {
+        for (size_t i=0; i<ops; ++i)
+        {
+            renderer.draw_background();
+        }
+    });
+    //A new scroll position every line, as a game scrolling diagonally would
+    LCDRegisters scrolled = lcd.registers();
+    runner.Time("lcd/draw_background_scrolling", [&renderer, &scrolled](size_t ops)
+    {
+        for (size_t i=0; i<ops; ++i)
+        {
+            scrolled.scroll_x = uint8_t(i);
+            scrolled.scroll_y = uint8_t(i * 3);
+            renderer.set_line(uint8_t(i % LCD_HEIGHT), scrolled);
+            renderer.draw_background();
+        }
+    });
+    renderer.set_line(0, lcd.registers());
+    runner.Time("lcd/draw_window", [&renderer](size_t ops)
+    {
+        for (size_t i=0; i<ops; ++i)
+        {
+            renderer.draw_window();
+        }
+    });
+    runner.Time("lcd/draw_sprites", [&renderer](size_t ops)
+    {
+        for (size_t i=0; i<ops; ++i)
+        {
+            renderer.draw_sprites();
+        }
+    });
+    
+    //After the first time, nothing has changed so the line is reused
+    LCDRegisters regs = lcd.registers();
+    runner.Time("lcd/draw_line_unchanged", [&renderer, &regs](size_t ops)
+    {
+        for (size_t i=0; i<ops; ++i)
+        {
+            renderer.draw_line(0, regs);
+        }
+    });
+    
+    //Draw a whole frame for these
+    for (size_t line=0; line<LCD_HEIGHT; ++line)
+    {
+        renderer.draw_line(uint8_t(line), regs);
+    }
+    const LCDFrame& frame = renderer.frame();
+    runner.Time("lcd/frame_hash", [&frame](size_t ops)
+    {
+        volatile uint64_t sink = 0;
+        for (size_t i=0; i<ops; ++i)
+        {
+            sink = frame_hash(frame);
+        }
+        (void)sink;
+    });
+    
+    FrameExpander expander(default_shades());
+    std::vector<uint32_t> pixels(LCD_WIDTH*LCD_HEIGHT);
+    runner.Time("lcd/expand_frame", [&expander, &frame, &pixels](size_t ops)
+    {
+        for (size_t i=0; i<ops; ++i)
+        {
+            expander.expand(frame, pixels.data(), LCD_WIDTH*sizeof(uint32_t));
+        }
+    });
+    
+    /*Cost of a tick that stays within a mode. The LCD is moved into the mode
+     then ticked without any cycles passing.*/
+    size_t cycles = 0;
+    for (auto& mode : LCD_MODES)
+    {
+        while ((map.read8(LCDSTAT) & 3) != mode.mode)
+        {
+            lcd.tick(++cycles);
+        }
+        
+        runner.Time("lcd/tick_" + mode.name, [&lcd, cycles](size_t ops)
+        {
+            for (size_t i=0; i<ops; ++i)
+            {
+                lcd.tick(cycles);
+            }
+        });
+    }
+    
+    //One cycle at a time, so this includes every mode change and line drawn
+    runner.Time("lcd/tick_per_cycle", [&lcd, &cycles](size_t ops)
+    {
+        for (size_t i=0; i<ops; ++i)
+        {
+            lcd.tick(++cycles);
+        }
+    });
+}
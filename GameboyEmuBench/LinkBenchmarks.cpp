@@ -0,0 +1,129 @@
+//
+//  LinkBenchmarks.cpp
+//  GameboyEmuBench
+//
+//  Created by David Spickett on 18/10/2026.
+//  Copyright © 2026 David Spickett. All rights reserved.
+//
+
+#include "Benchmarks.hpp"
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include "LinkCable.hpp"
+#include "utils.hpp"
+
+namespace
+{
+    //Offsets from 0xff00 for ldh
+    const uint8_t SB = 0x01;
+    const uint8_t SC = 0x02;
+    
+    //High RAM results
+    const uint8_t TRANSFERS_LOW  = 0x90;
+    const uint8_t TRANSFERS_HIGH = 0x91;
+    const uint8_t MISMATCHES     = 0x92;
+    
+    /*Both ends count up, sending their count and checking that the byte that
+     comes back is the other end's matching count. The slave arms with the
+     external clock, the master starts a transfer as soon as the last one finished.*/
+    RomBuilder link_rom(bool master)
+    {
+        RomBuilder rom(master ? "LINKMASTER" : "LINKSLAVE");
+        rom.ld(REG_B, 0);
+        rom.ld(REG_DE, 0);
+        
+        rom.label("next_transfer");
+        rom.ld(REG_A, REG_B);
+        rom.ldh_n_a(SB);
+        rom.ld(REG_A, uint8_t(master ? 0x81 : 0x80));
+        rom.ldh_n_a(SC);
+        rom.label("wait");
+        rom.ldh_a_n(SC);
+        rom.and_(0x80);
+        rom.jr(COND_NZ, "wait");
+        
+        rom.ldh_a_n(SB);
+        rom.cp(REG_B);
+        rom.jr(COND_Z, "matched");
+        rom.ldh_a_n(MISMATCHES);
+        rom.inc(REG_A);
+        rom.ldh_n_a(MISMATCHES);
+        rom.label("matched");
+        
+        rom.inc(REG_B);
+        rom.inc(REG_DE);
+        rom.ld(REG_A, REG_E);
+        rom.ldh_n_a(TRANSFERS_LOW);
+        rom.ld(REG_A, REG_D);
+        rom.ldh_n_a(TRANSFERS_HIGH);
+        rom.jr("next_transfer");
+        
+        return rom;
+    }
+    
+    struct LinkResult
+    {
+        size_t transfers;
+        uint8_t mismatches;
+    };
+}
+
+/*Two instances on their own threads joined by a LinkCable. Each keeps
+ running until both have done their frames so that neither is left
+ waiting on a byte from one that has stopped.*/
+void RegisterLinkBenchmarks(BenchmarkRunner& runner)
+{
+    std::string name = "link/pair";
+    if (!runner.wanted(name))
+    {
+        return;
+    }
+    
+    std::unique_ptr<BenchInstance> instances[2] = {
+        std::unique_ptr<BenchInstance>(new BenchInstance(link_rom(true), name + "/master", runner.args())),
+        std::unique_ptr<BenchInstance>(new BenchInstance(link_rom(false), name + "/slave", runner.args())),
+    };
+    LinkCable cable;
+    LinkResult results[2];
+    std::atomic<int> running(2);
+    
+    auto run = [&](size_t num)
+    {
+        BenchInstance& inst = *instances[num];
+        SerialLink& end = cable.end(num);
+        inst.map.connect_serial(&end);
+        
+        inst.RunFrames(runner.args().macro_frames);
+        results[num].transfers = inst.map.read8(0xff00 | TRANSFERS_LOW) |
+                                 (inst.map.read8(0xff00 | TRANSFERS_HIGH) << 8);
+        results[num].mismatches = inst.map.read8(0xff00 | MISMATCHES);
+        
+        --running;
+        while (running)
+        {
+            Step(inst.proc);
+        }
+        end.disconnect();
+    };
+    
+    auto start = std::chrono::steady_clock::now();
+    std::thread master(run, 0);
+    std::thread slave(run, 1);
+    master.join();
+    slave.join();
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+    
+    for (auto& r : results)
+    {
+        if (!r.transfers || r.mismatches)
+        {
+            throw std::runtime_error(formatted_string(
+                "%s: %zu transfers with %u mismatched bytes.", name.c_str(), r.transfers, r.mismatches));
+        }
+    }
+    
+    runner.Report(name + "/fps", runner.args().macro_frames / secs, "frames/s", true);
+    runner.Report(name + "/transfers", results[0].transfers / secs, "transfers/s", true);
+}
@@ -0,0 +1,54 @@
+//
+//  MacroBenchmarks.cpp
+//  GameboyEmuBench
+//
+//  Created by David Spickett on 18/10/2026.
+//  Copyright © 2026 David Spickett. All rights reserved.
+//
+
+#include "Benchmarks.hpp"
+#include <chrono>
+#include <memory>
+#include "Workloads.hpp"
+#include "TraceBuffer.hpp"
+
+namespace
+{
+    void RunMacro(BenchmarkRunner& runner, const Workload& w, const std::string& name, TraceBuffer* trace)
+    {
+        std::unique_ptr<BenchInstance> inst(new BenchInstance(w.build(), name, runner.args()));
+        inst->proc.m_trace = trace;
+        //Get past any start up effects before timing
+        inst->RunFrames(1);
+        
+        auto start = std::chrono::steady_clock::now();
+        size_t steps = inst->RunFrames(runner.args().macro_frames);
+        double secs = std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+        
+        runner.Report(name + "/mips", (steps / secs) / 1e6, "MIPS", true);
+        runner.Report(name + "/fps", runner.args().macro_frames / secs, "frames/s", true);
+    }
+}
+
+void RegisterMacroBenchmarks(BenchmarkRunner& runner)
+{
+    for (auto& w : GetWorkloads())
+    {
+        std::string name = "macro/" + w.name;
+        if (runner.wanted(name))
+        {
+            RunMacro(runner, w, name, nullptr);
+        }
+    }
+    
+    //Compare against macro/alu_loop to get the cost of instruction tracing
+    for (auto& w : GetWorkloads())
+    {
+        std::string name = "macro/traced/" + w.name;
+        if ((w.name == "alu_loop") && runner.wanted(name))
+        {
+            TraceBuffer trace;
+            RunMacro(runner, w, name, &trace);
+        }
+    }
+}
@@ -0,0 +1,77 @@
+//
+//  MultiBenchmarks.cpp
+//  GameboyEmuBench
+//
+//  Created by David Spickett on 18/10/2026.
+//  Copyright © 2026 David Spickett. All rights reserved.
+//
+
+#include "Benchmarks.hpp"
+#include <chrono>
+#include <memory>
+#include "Workloads.hpp"
+#include "InstanceGroup.hpp"
+
+namespace
+{
+    //Roughly one frame's worth of instructions for the workloads
+    const size_t STEPS_PER_FRAME = 10000;
+    
+    using Instances = std::vector<std::unique_ptr<BenchInstance>>;
+    
+    //Different workloads so that each instance has its own working set
+    Instances make_instances(BenchmarkRunner& runner, size_t count, const std::string& name)
+    {
+        std::vector<Workload> workloads = GetWorkloads();
+        Instances instances;
+        for (size_t i=0; i<count; ++i)
+        {
+            const Workload& w = workloads[i % workloads.size()];
+            instances.push_back(std::unique_ptr<BenchInstance>(
+                new BenchInstance(w.build(), name + "/" + w.name, runner.args())));
+            instances.back()->RunFrames(1);
+        }
+        return instances;
+    }
+    
+    double seconds_since(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+    }
+}
+
+//Aggregate instructions per second of N instances sharing one thread
+void RegisterMultiBenchmarks(BenchmarkRunner& runner)
+{
+    size_t steps = runner.args().macro_frames * STEPS_PER_FRAME;
+    
+    for (size_t count=2; count<=4; ++count)
+    {
+        std::string name = formatted_string("multi/%zu", count);
+        if (!runner.wanted(name))
+        {
+            continue;
+        }
+        
+        Instances serial = make_instances(runner, count, name + "/back_to_back");
+        auto start = std::chrono::steady_clock::now();
+        for (auto& inst : serial)
+        {
+            for (size_t i=0; i<steps; ++i)
+            {
+                Step(inst->proc);
+            }
+        }
+        runner.Report(name + "/back_to_back/mips", ((steps*count) / seconds_since(start)) / 1e6, "MIPS", true);
+        
+        Instances interleaved = make_instances(runner, count, name + "/interleaved");
+        InstanceGroup group;
+        for (auto& inst : interleaved)
+        {
+            group.Add(inst->proc);
+        }
+        start = std::chrono::steady_clock::now();
+        group.Run(steps);
+        runner.Report(name + "/interleaved/mips", ((steps*count) / seconds_since(start)) / 1e6, "MIPS", true);
+    }
+}
@@ -0,0 +1,269 @@
+//
+//  RomBuilder.cpp
+//  GameboyEmuBench
+//
+//  Created by David Spickett on 18/10/2026.
+//  Copyright © 2026 David Spickett. All rights reserved.
+//
+
+#include "RomBuilder.hpp"
+#include <fstream>
+#include <stdexcept>
+#include "utils.hpp"
+
+namespace
+{
+    const uint16_t ENTRY_POINT     = 0x0100;
+    const uint16_t LOGO_START      = 0x0104;
+    const uint16_t TITLE_START     = 0x0134;
+    const size_t TITLE_LEN         = 11;
+    const uint16_t CART_TYPE       = 0x0147;
+    const uint16_t ROM_SIZE        = 0x0148;
+    const uint16_t HEADER_CHECKSUM = 0x014d;
+    const uint16_t GLOBAL_CHECKSUM = 0x014e;
+    
+    //Checked by the boot ROM, which won't start the cartridge if it's wrong
+    const uint8_t NINTENDO_LOGO[] = {
+        0xce, 0xed, 0x66, 0x66, 0xcc, 0x0d, 0x00, 0x0b, 0x03, 0x73, 0x00, 0x83,
+        0x00, 0x0c, 0x00, 0x0d, 0x00, 0x08, 0x11, 0x1f, 0x88, 0x89, 0x00, 0x0e,
+        0xdc, 0xcc, 0x6e, 0xe6, 0xdd, 0xdd, 0xd9, 0x99, 0xbb, 0xbb, 0x67, 0x63,
+        0x6e, 0x0e, 0xec, 0xcc, 0xdd, 0xdc, 0x99, 0x9f, 0xbb, 0xb9, 0x33, 0x3e,
+    };
+    
+    uint8_t rom_size_code(size_t num_banks)
+    {
+        //32K << code
+        uint8_t code = 0;
+        while ((size_t(2) << code) < num_banks)
+        {
+            ++code;
+        }
+        if ((size_t(2) << code) != num_banks)
+        {
+            throw std::runtime_error(formatted_string("ROM bank count %zu is not a power of 2.", num_banks));
+        }
+        return code;
+    }
+}
+
+size_t RomBuilder::Location::offset() const
+{
+    if (bank == 0)
+    {
+        return addr;
+    }
+    return (bank*ROM_BANK_SIZE) + (addr-ROM_BANK_SIZE);
+}
+
+RomBuilder::RomBuilder(std::string title, uint8_t cartridge_type, size_t num_banks):
+    m_data(num_banks*ROM_BANK_SIZE, 0),
+    m_bank(0),
+    m_pos(ENTRY_POINT)
+{
+    //nop, jp ROM_CODE_START
+    emit({0x00, 0xc3});
+    emit16(ROM_CODE_START);
+    
+    title.resize(TITLE_LEN, '\0');
+    std::copy(title.begin(), title.end(), m_data.begin()+TITLE_START);
+    
+    m_data[CART_TYPE] = cartridge_type;
+    m_data[ROM_SIZE] = rom_size_code(num_banks);
+    
+    m_pos = ROM_CODE_START;
+}
+
+void RomBuilder::seek(uint16_t addr, size_t bank)
+{
+    bool in_bank_0 = addr < ROM_BANK_SIZE;
+    if ((bank*ROM_BANK_SIZE >= m_data.size()) ||
+        (in_bank_0 != (bank == 0)) ||
+        (addr >= 2*ROM_BANK_SIZE))
+    {
+        throw std::runtime_error(formatted_string("Can't seek to bank %zu addr 0x%04x", bank, addr));
+    }
+    
+    m_bank = bank;
+    m_pos = addr;
+}
+
+void RomBuilder::emit(uint8_t byte)
+{
+    Location loc = {m_bank, m_pos};
+    bool bank_end = (m_bank == 0) ? (m_pos >= ROM_BANK_SIZE) : (m_pos >= 2*ROM_BANK_SIZE);
+    if (bank_end)
+    {
+        throw std::runtime_error(formatted_string("ROM bank %zu overflowed at 0x%04x", m_bank, m_pos));
+    }
+    m_data[loc.offset()] = byte;
+    ++m_pos;
+}
+
+void RomBuilder::emit(std::initializer_list<uint8_t> bytes)
+{
+    for (auto b : bytes)
+    {
+        emit(b);
+    }
+}
+
+void RomBuilder::emit16(uint16_t value)
+{
+    emit(uint8_t(value));
+    emit(uint8_t(value >> 8));
+}
+
+void RomBuilder::label(const std::string& name)
+{
+    if (m_labels.find(name) != m_labels.end())
+    {
+        throw std::runtime_error(formatted_string("Label %s defined twice.", name.c_str()));
+    }
+    Location loc = {m_bank, m_pos};
+    m_labels[name] = loc;
+}
+
+void RomBuilder::fixup(const std::string& target, FixupKind kind)
+{
+    Fixup f = {{m_bank, m_pos}, target, kind};
+    m_fixups.push_back(f);
+    if (kind == FIXUP_ABSOLUTE)
+    {
+        emit16(0);
+    }
+    else
+    {
+        emit(0);
+    }
+}
+
+void RomBuilder::ld(Reg16 dst, uint16_t value)
+{
+    emit(0x01 | (dst << 4));
+    emit16(value);
+}
+
+void RomBuilder::ld(Reg16 dst, const std::string& target)
+{
+    emit(0x01 | (dst << 4));
+    fixup(target, FIXUP_ABSOLUTE);
+}
+
+void RomBuilder::ld_addr_a(uint16_t addr)
+{
+    emit(0xea);
+    emit16(addr);
+}
+
+void RomBuilder::ld_a_addr(uint16_t addr)
+{
+    emit(0xfa);
+    emit16(addr);
+}
+
+void RomBuilder::jp(const std::string& target)
+{
+    emit(0xc3);
+    fixup(target, FIXUP_ABSOLUTE);
+}
+
+void RomBuilder::jp(Condition cond, const std::string& target)
+{
+    emit(0xc2 | (cond << 3));
+    fixup(target, FIXUP_ABSOLUTE);
+}
+
+void RomBuilder::jr(const std::string& target)
+{
+    emit(0x18);
+    fixup(target, FIXUP_RELATIVE);
+}
+
+void RomBuilder::jr(Condition cond, const std::string& target)
+{
+    emit(0x20 | (cond << 3));
+    fixup(target, FIXUP_RELATIVE);
+}
+
+void RomBuilder::call(const std::string& target)
+{
+    emit(0xcd);
+    fixup(target, FIXUP_ABSOLUTE);
+}
+
+void RomBuilder::call(uint16_t addr)
+{
+    emit(0xcd);
+    emit16(addr);
+}
+
+const std::vector<uint8_t>& RomBuilder::Build()
+{
+    for (auto& f : m_fixups)
+    {
+        auto label = m_labels.find(f.target);
+        if (label == m_labels.end())
+        {
+            throw std::runtime_error(formatted_string("Undefined label %s", f.target.c_str()));
+        }
+        
+        const Location& to = label->second;
+        //A jump can only reach bank 0 or whatever is paged in with it
+        if ((to.bank != 0) && (to.bank != f.at.bank))
+        {
+            throw std::runtime_error(formatted_string("Label %s is in another bank.", f.target.c_str()));
+        }
+        
+        size_t offset = f.at.offset();
+        if (f.kind == FIXUP_ABSOLUTE)
+        {
+            m_data[offset] = uint8_t(to.addr);
+            m_data[offset+1] = uint8_t(to.addr >> 8);
+        }
+        else
+        {
+            //Relative to the address after the jr
+            int distance = int(to.addr) - int(f.at.addr+1);
+            if ((distance < -128) || (distance > 127) || (to.bank != f.at.bank))
+            {
+                throw std::runtime_error(formatted_string("Label %s is out of range of jr.", f.target.c_str()));
+            }
+            m_data[offset] = uint8_t(int8_t(distance));
+        }
+    }
+    
+    std::copy(std::begin(NINTENDO_LOGO), std::end(NINTENDO_LOGO), m_data.begin()+LOGO_START);
+    
+    //Header checksum covers the title to the version number
+    uint8_t header_sum = 0;
+    for (uint16_t addr=TITLE_START; addr<HEADER_CHECKSUM; ++addr)
+    {
+        header_sum = header_sum - m_data[addr] - 1;
+    }
+    m_data[HEADER_CHECKSUM] = header_sum;
+    
+    //Global checksum is every byte apart from itself, stored big endian
+    m_data[GLOBAL_CHECKSUM] = 0;
+    m_data[GLOBAL_CHECKSUM+1] = 0;
+    uint16_t global_sum = 0;
+    for (auto b : m_data)
+    {
+        global_sum += b;
+    }
+    m_data[GLOBAL_CHECKSUM] = global_sum >> 8;
+    m_data[GLOBAL_CHECKSUM+1] = uint8_t(global_sum);
+    
+    return m_data;
+}
+
+void RomBuilder::Save(const std::string& path)
+{
+    Build();
+    
+    std::ofstream out(path.c_str(), std::ofstream::binary);
+    if (!out.is_open())
+    {
+        throw std::runtime_error(formatted_string("Could not write ROM to %s", path.c_str()));
+    }
+    out.write(reinterpret_cast<const char*>(m_data.data()), m_data.size());
+}
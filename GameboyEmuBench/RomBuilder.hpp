@@ -0,0 +1,130 @@
+//
+//  RomBuilder.hpp
+//  GameboyEmuBench
+//
+//  Created by David Spickett on 18/10/2026.
+//  Copyright © 2026 David Spickett. All rights reserved.
+//
+
+#ifndef RomBuilder_hpp
+#define RomBuilder_hpp
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <map>
+#include <initializer_list>
+
+const uint16_t ROM_CODE_START = 0x0150;
+const size_t ROM_BANK_SIZE    = 0x4000;
+
+const uint8_t CART_ROM_ONLY = 0x00;
+const uint8_t CART_MBC1     = 0x01;
+
+//Register encodings as used in the opcodes
+enum Reg8 { REG_B, REG_C, REG_D, REG_E, REG_H, REG_L, REG_HL_IND, REG_A };
+enum Reg16 { REG_BC, REG_DE, REG_HL, REG_SP, REG_AF=REG_SP };
+enum Condition { COND_NZ, COND_Z, COND_NC, COND_C };
+
+/*A small assembler for building deterministic test ROMs. Code is emitted
+ from ROM_CODE_START in bank 0 and the entry point at 0x100 jumps there.
+ Labels can be used before they are defined, they are resolved by Build().
+ Build() also fills in the logo, header checksum and global checksum so
+ the image is a valid cartridge.*/
+class RomBuilder
+{
+public:
+    explicit RomBuilder(std::string title, uint8_t cartridge_type=CART_ROM_ONLY, size_t num_banks=2);
+    
+    void emit(uint8_t byte);
+    void emit(std::initializer_list<uint8_t> bytes);
+    void emit16(uint16_t value);
+    
+    //Address the next byte will be emitted at
+    uint16_t here() const { return m_pos; }
+    //Banks other than 0 are emitted at 0x4000-0x7fff
+    void seek(uint16_t addr, size_t bank=0);
+    
+    void label(const std::string& name);
+    
+    //Instructions
+    void nop()  { emit(0x00); }
+    void halt() { emit(0x76); }
+    void di()   { emit(0xf3); }
+    void ei()   { emit(0xfb); }
+    void ret()  { emit(0xc9); }
+    void reti() { emit(0xd9); }
+    
+    void ld(Reg8 dst, Reg8 src)      { emit(0x40 | (dst << 3) | src); }
+    void ld(Reg8 dst, uint8_t value) { emit({uint8_t(0x06 | (dst << 3)), value}); }
+    void ld(Reg16 dst, uint16_t value);
+    void ld(Reg16 dst, const std::string& target);
+    void ld_hli_a()                  { emit(0x22); }
+    void ld_a_hli()                  { emit(0x2a); }
+    void ld_de_a()                   { emit(0x12); }
+    void ld_a_de()                   { emit(0x1a); }
+    void ld_addr_a(uint16_t addr);
+    void ld_a_addr(uint16_t addr);
+    void ldh_n_a(uint8_t offset)     { emit({0xe0, offset}); }
+    void ldh_a_n(uint8_t offset)     { emit({0xf0, offset}); }
+    
+    void inc(Reg8 r)   { emit(0x04 | (r << 3)); }
+    void dec(Reg8 r)   { emit(0x05 | (r << 3)); }
+    void inc(Reg16 r)  { emit(0x03 | (r << 4)); }
+    void dec(Reg16 r)  { emit(0x0b | (r << 4)); }
+    void push(Reg16 r) { emit(0xc5 | (r << 4)); }
+    void pop(Reg16 r)  { emit(0xc1 | (r << 4)); }
+    
+    void add(Reg8 r)  { emit(0x80 | r); }
+    void adc(Reg8 r)  { emit(0x88 | r); }
+    void sub(Reg8 r)  { emit(0x90 | r); }
+    void and_(Reg8 r) { emit(0xa0 | r); }
+    void xor_(Reg8 r) { emit(0xa8 | r); }
+    void or_(Reg8 r)  { emit(0xb0 | r); }
+    void cp(Reg8 r)   { emit(0xb8 | r); }
+    void add(uint8_t value)  { emit({0xc6, value}); }
+    void and_(uint8_t value) { emit({0xe6, value}); }
+    void xor_(uint8_t value) { emit({0xee, value}); }
+    void cp(uint8_t value)   { emit({0xfe, value}); }
+    void rl(Reg8 r)   { emit({0xcb, uint8_t(0x10 | r)}); }
+    void swap(Reg8 r) { emit({0xcb, uint8_t(0x30 | r)}); }
+    
+    void jp(const std::string& target);
+    void jp(Condition cond, const std::string& target);
+    void jr(const std::string& target);
+    void jr(Condition cond, const std::string& target);
+    void call(const std::string& target);
+    void call(uint16_t addr);
+    
+    //Fill in labels, logo and checksums
+    const std::vector<uint8_t>& Build();
+    void Save(const std::string& path);
+    
+private:
+    struct Location
+    {
+        size_t bank;
+        uint16_t addr;
+        
+        size_t offset() const;
+    };
+    
+    enum FixupKind { FIXUP_ABSOLUTE, FIXUP_RELATIVE };
+    struct Fixup
+    {
+        Location at;
+        std::string target;
+        FixupKind kind;
+    };
+    
+    void fixup(const std::string& target, FixupKind kind);
+    
+    std::vector<uint8_t> m_data;
+    size_t m_bank;
+    uint16_t m_pos;
+    
+    std::map<std::string, Location> m_labels;
+    std::vector<Fixup> m_fixups;
+};
+
+#endif /* RomBuilder_hpp */
@@ -0,0 +1,64 @@
+//
+//  UpscaleBenchmarks.cpp
+//  GameboyEmuBench
+//
+//  Created by David Spickett on 18/10/2026.
+//  Copyright © 2026 David Spickett. All rights reserved.
+//
+
+#include "Benchmarks.hpp"
+#include "Upscaler.hpp"
+#include <vector>
+
+namespace
+{
+    struct FilterScale
+    {
+        std::string name;
+        ScaleFilter filter;
+        int factor;
+    };
+    
+    const std::vector<FilterScale> FILTER_SCALES = {
+        {"nearest",   FILTER_NEAREST,   2},
+        {"nearest",   FILTER_NEAREST,   3},
+        {"nearest",   FILTER_NEAREST,   4},
+        {"nearest",   FILTER_NEAREST,   6},
+        {"scale2x",   FILTER_SCALE2X,   2},
+        {"scale2x",   FILTER_SCALE2X,   4},
+        {"scale3x",   FILTER_SCALE3X,   3},
+        {"scale3x",   FILTER_SCALE3X,   6},
+        {"scanlines", FILTER_SCANLINES, 3},
+        {"scanlines", FILTER_SCANLINES, 6},
+    };
+}
+
+void RegisterUpscaleBenchmarks(BenchmarkRunner& runner)
+{
+    //Diagonal stripes of all 4 shades, so the smoothing filters have edges to work on
+    LCDFrame frame;
+    for (size_t i=0; i<frame.size(); ++i)
+    {
+        size_t y = i / (LCD_WIDTH/LCD_PIXELS_PER_BYTE);
+        frame[i] = uint8_t(0x1b << ((y + i) % 4 * 2)) | uint8_t(0x1b >> (8 - (y + i) % 4 * 2));
+    }
+    
+    std::vector<uint32_t> pixels(LCD_WIDTH*LCD_HEIGHT);
+    FrameExpander(default_shades()).expand(frame, pixels.data(), LCD_WIDTH*sizeof(uint32_t));
+    
+    for (auto& fs : FILTER_SCALES)
+    {
+        Upscaler upscaler(fs.filter, fs.factor);
+        std::vector<uint32_t> out(LCD_WIDTH*LCD_HEIGHT*fs.factor*fs.factor);
+        const size_t pitch = LCD_WIDTH*fs.factor*sizeof(uint32_t);
+        
+        runner.Time(formatted_string("upscale/%s/%d", fs.name.c_str(), fs.factor),
+                    [&upscaler, &out, &pixels, pitch](size_t ops)
+        {
+            for (size_t i=0; i<ops; ++i)
+            {
+                upscaler.scale(pixels.data(), out.data(), pitch);
+            }
+        });
+    }
+}
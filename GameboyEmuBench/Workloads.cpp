@@ -0,0 +1,359 @@
+//
+//  Workloads.cpp
+//  GameboyEmuBench
+//
+//  Created by David Spickett on 18/10/2026.
+//  Copyright © 2026 David Spickett. All rights reserved.
+//
+
+#include "Workloads.hpp"
+#include "MemoryManager.hpp"
+#include "utils.hpp"
+
+namespace
+{
+    //Offsets from 0xff00 for ldh
+    const uint8_t TIMA = 0x05;
+    const uint8_t TMA  = 0x06;
+    const uint8_t TAC  = 0x07;
+    const uint8_t LCDC = 0x40;
+    const uint8_t STAT = 0x41;
+    const uint8_t SCY  = 0x42;
+    const uint8_t SCX  = 0x43;
+    const uint8_t DMA  = 0x46;
+    const uint8_t BGP  = 0x47;
+    const uint8_t OBP0 = 0x48;
+    const uint8_t OBP1 = 0x49;
+    const uint8_t WY   = 0x4a;
+    const uint8_t WX   = 0x4b;
+    const uint8_t IE   = 0xff;
+    
+    const uint16_t VBLANK_VECTOR = 0x0040;
+    const uint16_t STAT_VECTOR   = 0x0048;
+    const uint16_t TIMER_VECTOR  = 0x0050;
+    
+    const uint16_t HRAM_START  = 0xff80;
+    //High RAM counters, after the DMA routine
+    const uint8_t VBLANK_COUNT = 0x90;
+    const uint8_t STAT_COUNT   = 0x91;
+    const uint8_t TIMER_COUNT  = 0x92;
+    
+    //Sprite attributes are built here then DMAd to OAM
+    const uint16_t SHADOW_OAM = 0xc100;
+    const uint8_t NUM_SPRITES = 40;
+    
+    void ldh_n(RomBuilder& rom, uint8_t offset, uint8_t value)
+    {
+        rom.ld(REG_A, value);
+        rom.ldh_n_a(offset);
+    }
+    
+    void vector_to(RomBuilder& rom, uint16_t vector, const std::string& target)
+    {
+        uint16_t pos = rom.here();
+        rom.seek(vector);
+        rom.jp(target);
+        rom.seek(pos);
+    }
+    
+    //Fill bc bytes from hl with the low byte of the address
+    void fill_with_addr(RomBuilder& rom, const std::string& name, uint16_t start, uint16_t len)
+    {
+        rom.ld(REG_HL, start);
+        rom.ld(REG_BC, len);
+        rom.label(name);
+        rom.ld(REG_A, REG_L);
+        rom.ld_hli_a();
+        rom.dec(REG_BC);
+        rom.ld(REG_A, REG_B);
+        rom.or_(REG_C);
+        rom.jr(COND_NZ, name);
+    }
+    
+    void increment_hram(RomBuilder& rom, uint8_t offset)
+    {
+        rom.push(REG_AF);
+        rom.ldh_a_n(offset);
+        rom.inc(REG_A);
+        rom.ldh_n_a(offset);
+        rom.pop(REG_AF);
+    }
+    
+    /*OAM DMA has to be started from high RAM since the CPU can't read
+     anything else while the transfer runs. This copies a routine there which
+     starts the DMA then waits for it to finish.*/
+    void install_dma_routine(RomBuilder& rom)
+    {
+        const uint8_t routine[] = {
+            0x3e, uint8_t(SHADOW_OAM >> 8), //ld a, SHADOW_OAM >> 8
+            0xe0, DMA,                      //ldh (DMA), a
+            0x3e, 64,                       //ld a, 64
+            0x3d,                           //dec a
+            0x20, 0xfd,                     //jr nz, -3
+            0xc9,                           //ret
+        };
+        
+        rom.ld(REG_HL, "dma_routine");
+        rom.ld(REG_DE, HRAM_START);
+        rom.ld(REG_B, uint8_t(sizeof(routine)));
+        rom.label("copy_dma_routine");
+        rom.ld_a_hli();
+        rom.ld_de_a();
+        rom.inc(REG_DE);
+        rom.dec(REG_B);
+        rom.jr(COND_NZ, "copy_dma_routine");
+        rom.jp("dma_routine_end");
+        
+        rom.label("dma_routine");
+        for (auto b : routine)
+        {
+            rom.emit(b);
+        }
+        rom.label("dma_routine_end");
+    }
+    
+    void halt_forever(RomBuilder& rom)
+    {
+        rom.label("main_loop");
+        rom.halt();
+        rom.nop();
+        rom.jr("main_loop");
+    }
+    
+    RomBuilder alu_loop()
+    {
+        RomBuilder rom("ALULOOP");
+        rom.label("outer");
+        rom.ld(REG_B, 0xff);
+        rom.label("inner");
+        rom.add(REG_B);
+        rom.xor_(REG_C);
+        rom.ld(REG_C, REG_A);
+        rom.rl(REG_C);
+        rom.or_(REG_C);
+        rom.and_(0x7f);
+        rom.swap(REG_A);
+        rom.dec(REG_B);
+        rom.jr(COND_NZ, "inner");
+        rom.jp("outer");
+        return rom;
+    }
+    
+    RomBuilder memcpy_loop()
+    {
+        RomBuilder rom("MEMCPY");
+        rom.label("outer");
+        rom.ld(REG_HL, 0x1000);
+        rom.ld(REG_DE, 0xc000);
+        rom.ld(REG_BC, 0x1000);
+        rom.label("copy");
+        rom.ld_a_hli();
+        rom.ld_de_a();
+        rom.inc(REG_DE);
+        rom.dec(REG_BC);
+        rom.ld(REG_A, REG_B);
+        rom.or_(REG_C);
+        rom.jr(COND_NZ, "copy");
+        rom.jp("outer");
+        return rom;
+    }
+    
+    RomBuilder sprite_scene()
+    {
+        RomBuilder rom("SPRITES");
+        vector_to(rom, VBLANK_VECTOR, "vblank");
+        
+        install_dma_routine(rom);
+        fill_with_addr(rom, "fill_tiles", LCD_MEM_START, 0x1000);
+        
+        //Sprites staggered so that lines have up to 10 sprites on them
+        rom.ld(REG_HL, SHADOW_OAM);
+        rom.ld(REG_B, NUM_SPRITES);
+        rom.ld(REG_D, 16); //Y
+        rom.ld(REG_E, 8);  //X
+        rom.label("init_sprites");
+        rom.ld(REG_A, REG_D);
+        rom.ld_hli_a();
+        rom.add(3);
+        rom.ld(REG_D, REG_A);
+        rom.ld(REG_A, REG_E);
+        rom.ld_hli_a();
+        rom.add(4);
+        rom.ld(REG_E, REG_A);
+        rom.ld(REG_A, REG_B);     //Tile
+        rom.ld_hli_a();
+        rom.and_(0x30);           //Vary palette and flips
+        rom.ld_hli_a();
+        rom.dec(REG_B);
+        rom.jr(COND_NZ, "init_sprites");
+        
+        ldh_n(rom, BGP, 0xe4);
+        ldh_n(rom, OBP0, 0xe4);
+        ldh_n(rom, OBP1, 0x1b);
+        //LCD on, tiles at 0x8000, sprites and background on
+        ldh_n(rom, LCDC, 0x93);
+        ldh_n(rom, IE, 0x01);
+        rom.ei();
+        halt_forever(rom);
+        
+        //Copy sprites to OAM then move them all right by one pixel
+        rom.label("vblank");
+        rom.push(REG_AF);
+        rom.push(REG_BC);
+        rom.push(REG_HL);
+        rom.call(HRAM_START);
+        rom.ld(REG_HL, SHADOW_OAM+1);
+        rom.ld(REG_B, NUM_SPRITES);
+        rom.label("move_sprites");
+        rom.inc(REG_HL_IND);
+        rom.ld(REG_A, REG_L);
+        rom.add(4);
+        rom.ld(REG_L, REG_A);
+        rom.dec(REG_B);
+        rom.jr(COND_NZ, "move_sprites");
+        rom.pop(REG_HL);
+        rom.pop(REG_BC);
+        rom.pop(REG_AF);
+        rom.reti();
+        
+        return rom;
+    }
+    
+    RomBuilder scroll_background()
+    {
+        RomBuilder rom("SCROLL");
+        vector_to(rom, VBLANK_VECTOR, "vblank");
+        
+        fill_with_addr(rom, "fill_tiles", LCD_MEM_START, 0x1000);
+        //Both tile maps
+        fill_with_addr(rom, "fill_maps", LCD_BGRND_DATA, 0x800);
+        
+        ldh_n(rom, BGP, 0xe4);
+        ldh_n(rom, WY, 72);
+        ldh_n(rom, WX, 7+80);
+        //LCD on, window on using 0x9c00, tiles at 0x8000, background on
+        ldh_n(rom, LCDC, 0xf1);
+        ldh_n(rom, IE, 0x01);
+        rom.ei();
+        halt_forever(rom);
+        
+        //Scroll diagonally by one pixel a frame
+        rom.label("vblank");
+        rom.push(REG_AF);
+        rom.ldh_a_n(SCX);
+        rom.inc(REG_A);
+        rom.ldh_n_a(SCX);
+        rom.ldh_a_n(SCY);
+        rom.inc(REG_A);
+        rom.ldh_n_a(SCY);
+        rom.pop(REG_AF);
+        rom.reti();
+        
+        return rom;
+    }
+    
+    RomBuilder interrupt_storm()
+    {
+        RomBuilder rom("INTSTORM");
+        vector_to(rom, VBLANK_VECTOR, "vblank");
+        vector_to(rom, STAT_VECTOR, "stat");
+        vector_to(rom, TIMER_VECTOR, "timer");
+        
+        //Fastest timer, overflowing every other increment
+        ldh_n(rom, TMA, 0xfe);
+        ldh_n(rom, TIMA, 0xfe);
+        ldh_n(rom, TAC, 0x05);
+        //STAT interrupt on every HBLANK
+        ldh_n(rom, STAT, 0x08);
+        ldh_n(rom, IE, 0x07);
+        rom.ei();
+        
+        //Keep the CPU busy between interrupts
+        rom.label("main_loop");
+        rom.inc(REG_B);
+        rom.add(REG_B);
+        rom.jr("main_loop");
+        
+        rom.label("vblank");
+        increment_hram(rom, VBLANK_COUNT);
+        rom.reti();
+        rom.label("stat");
+        increment_hram(rom, STAT_COUNT);
+        rom.reti();
+        rom.label("timer");
+        increment_hram(rom, TIMER_COUNT);
+        rom.reti();
+        
+        return rom;
+    }
+    
+    RomBuilder bank_switch()
+    {
+        const size_t num_banks = 4;
+        const uint16_t routine = 0x4000;
+        const uint16_t table = 0x4100;
+        
+        RomBuilder rom("BANKSWITCH", CART_MBC1, num_banks);
+        
+        //Switch through banks 1-3, calling the routine in each
+        rom.label("main_loop");
+        rom.ld(REG_D, 1);
+        rom.label("next_bank");
+        rom.ld(REG_A, REG_D);
+        rom.ld_addr_a(0x2000);
+        rom.call(routine);
+        rom.inc(REG_D);
+        rom.ld(REG_A, REG_D);
+        rom.cp(uint8_t(num_banks));
+        rom.jr(COND_NZ, "next_bank");
+        rom.jr("main_loop");
+        
+        //Each bank sums its own table into c
+        for (size_t bank=1; bank<num_banks; ++bank)
+        {
+            std::string loop = formatted_string("sum_bank_%zu", bank);
+            rom.seek(routine, bank);
+            rom.ld(REG_HL, table);
+            rom.ld(REG_B, 0);
+            rom.label(loop);
+            rom.ld(REG_A, REG_C);
+            rom.add(REG_HL_IND);
+            rom.ld(REG_C, REG_A);
+            rom.inc(REG_HL);
+            rom.dec(REG_B);
+            rom.jr(COND_NZ, loop);
+            rom.ret();
+            
+            rom.seek(table, bank);
+            for (auto i=0; i<256; ++i)
+            {
+                rom.emit(uint8_t(i*bank));
+            }
+        }
+        
+        return rom;
+    }
+}
+
+const std::vector<Workload>& GetWorkloads()
+{
+    static const std::vector<Workload> workloads = {
+        {"alu_loop",        "Register ALU operations in a tight loop.",               alu_loop},
+        {"memcpy_loop",     "Copies 4K of ROM to work RAM repeatedly.",               memcpy_loop},
+        {"sprite_scene",    "40 sprites updated by OAM DMA every frame.",             sprite_scene},
+        {"scroll_bg",       "Background and window with a scroll every frame.",       scroll_background},
+        {"interrupt_storm", "Timer, STAT and VBLANK interrupts as often as possible.", interrupt_storm},
+        {"bank_switch",     "MBC1 ROM bank switching with code run from each bank.",  bank_switch},
+    };
+    return workloads;
+}
+
+void WriteWorkloadRoms(const std::string& dir)
+{
+    for (auto& w : GetWorkloads())
+    {
+        std::string path = dir + "/" + w.name + ".gb";
+        w.build().Save(path);
+        printf("%-20s %s\n", path.c_str(), w.description.c_str());
+    }
+}
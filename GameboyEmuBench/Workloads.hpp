@@ -0,0 +1,27 @@
+//
+//  Workloads.hpp
+//  GameboyEmuBench
+//
+//  Created by David Spickett on 18/10/2026.
+//  Copyright © 2026 David Spickett. All rights reserved.
+//
+
+#ifndef Workloads_hpp
+#define Workloads_hpp
+
+#include "RomBuilder.hpp"
+
+//A generated ROM standing in for a kind of game behaviour
+struct Workload
+{
+    std::string name;
+    std::string description;
+    RomBuilder (*build)();
+};
+
+const std::vector<Workload>& GetWorkloads();
+
+//Write every workload ROM to dir as <name>.gb
+void WriteWorkloadRoms(const std::string& dir);
+
+#endif /* Workloads_hpp */
@@ -0,0 +1,51 @@
+//
+//  main.cpp
+//  GameboyEmuBench
+//
+//  Created by David Spickett on 18/10/2026.
+//  Copyright © 2026 David Spickett. All rights reserved.
+//
+
+#include <stdlib.h>
+#include "Benchmarks.hpp"
+#include "Workloads.hpp"
+
+int main(int argc, const char * argv[]) {
+    bench_args a = process_bench_args(argc, argv);
+    
+    if (!a.write_roms_dir.empty())
+    {
+        WriteWorkloadRoms(a.write_roms_dir);
+        return 0;
+    }
+    
+    //No window or speakers needed, but we still want to pay for rendering and mixing
+    setenv("SDL_VIDEODRIVER", "dummy", 0);
+    setenv("SDL_AUDIODRIVER", "dummy", 0);
+    
+    BenchmarkRunner runner(a);
+    RegisterCPUBenchmarks(runner);
+    RegisterMemoryBenchmarks(runner);
+    RegisterLCDBenchmarks(runner);
+    RegisterUpscaleBenchmarks(runner);
+    RegisterMacroBenchmarks(runner);
+    RegisterMultiBenchmarks(runner);
+    RegisterLinkBenchmarks(runner);
+    
+    if (!a.json_path.empty())
+    {
+        WriteJSON(runner.results(), a.json_path);
+    }
+    
+    if (!a.baseline_path.empty())
+    {
+        int regressions = CompareToBaseline(runner.results(), ReadJSON(a.baseline_path), a.threshold);
+        if (regressions)
+        {
+            printf("\n%d benchmark(s) regressed by more than %.1f%%\n", regressions, a.threshold);
+            return 1;
+        }
+    }
+    
+    return 0;
+}
@@ -0,0 +1,63 @@
+//
+//  main.cpp
+//  GameboyEmuTrace
+//
+//  Created by David Spickett on 18/10/2026.
+//  Copyright © 2026 David Spickett. All rights reserved.
+//
+
+#include <stdio.h>
+#include <string>
+#include <stdexcept>
+#include "TraceBuffer.hpp"
+#include "utils.hpp"
+#include "Disassembler.hpp"
+
+//Prints an instruction trace written by GameboyEmu as text, oldest first
+int main(int argc, const char * argv[]) {
+    std::string path;
+    size_t last = 0;
+    
+    for (auto i=1; i<argc; ++i)
+    {
+        std::string arg(argv[i]);
+        std::string last_arg = "--last=";
+        if (arg.find(last_arg) == 0)
+        {
+            last = std::stoul(arg.substr(last_arg.size(), std::string::npos), NULL, 10);
+        }
+        else
+        {
+            path = arg;
+        }
+    }
+    
+    if (path.empty())
+    {
+        printf("Usage: GameboyEmuTrace <trace file> [--last=<number of records>]\n");
+        return 1;
+    }
+    
+    std::vector<TraceRecord> recs = ReadTrace(path);
+    size_t first = ((last != 0) && (last < recs.size())) ? recs.size()-last : 0;
+    
+    for (size_t i=first; i<recs.size(); ++i)
+    {
+        const TraceRecord& r = recs[i];
+        
+        std::string bytes;
+        for (uint8_t b=0; b<sizeof(r.bytes); ++b)
+        {
+            bytes += (b < r.length) ? formatted_string("%02x ", r.bytes[b]) : "   ";
+        }
+        
+        printf("%12llu %04x: %s %-20s AF=%04x BC=%04x DE=%04x HL=%04x SP=%04x\n",
+               (unsigned long long)r.cycle,
+               r.pc,
+               bytes.c_str(),
+               disassemble(r.pc, r.bytes, r.length).c_str(),
+               r.af, r.bc, r.de, r.hl, r.sp);
+    }
+    
+    return 0;
+}